@@ -0,0 +1,70 @@
+#include "arena.h"
+
+// Allocations are aligned to this many bytes
+#define ARENA_ALIGN 16
+
+arena* arena_create(size_t block_size) {
+/* Creates an empty arena
+
+  Input(s):
+    size_t block_size: bytes of each block, rounded up to the alignment
+
+  Output(s):
+    arena* pool: the arena, to be released with arena_free
+*/
+  arena *pool = malloc(sizeof(*pool));
+  if (pool == NULL) {printf("Error allocating arena\n"); exit(0);}
+  pool->head = NULL;
+  pool->block_size = MAX((block_size + ARENA_ALIGN - 1)/ARENA_ALIGN*ARENA_ALIGN, ARENA_ALIGN);
+  pool->n_bytes = 0;
+  pool->n_reserved = 0;
+
+  return pool;
+}
+
+void* arena_alloc(arena* pool, size_t bytes) {
+  // Carves bytes from the current block, opening a new block when it is full
+  bytes = MAX((bytes + ARENA_ALIGN - 1)/ARENA_ALIGN*ARENA_ALIGN, ARENA_ALIGN);
+  arena_block *block = pool->head;
+  if ((block == NULL) || (block->size - block->used < bytes)) {
+    size_t size = MAX(bytes, pool->block_size);
+    arena_block *new_block = malloc(sizeof(arena_block) + size);
+    if (new_block == NULL) {printf("Error allocating arena block of %zu bytes\n", size); exit(0);}
+    new_block->size = size;
+    new_block->used = 0;
+    pool->n_reserved += size;
+    if ((block != NULL) && (size > pool->block_size)) {
+      // A dedicated block goes behind the current one, which keeps its free space
+      new_block->next = block->next;
+      block->next = new_block;
+    } else {
+      new_block->next = block;
+      pool->head = new_block;
+    }
+    block = new_block;
+  }
+  void *p = block->data + block->used;
+  block->used += bytes;
+  pool->n_bytes += bytes;
+
+  return p;
+}
+
+void* arena_calloc(arena* pool, size_t bytes) {
+  void *p = arena_alloc(pool, bytes);
+  memset(p, 0, bytes);
+  return p;
+}
+
+void arena_free(arena* pool) {
+  // Releases every allocation of the arena at once, safe to call on NULL
+  if (pool == NULL) {return;}
+  arena_block *block = pool->head;
+  while (block != NULL) {
+    arena_block *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(pool);
+  return;
+}
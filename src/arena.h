@@ -0,0 +1,33 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include "revmap.h"
+
+/* Bump arenas
+   Storage that lives for a whole phase of a run (the jump tables of a density
+   calculation) is carved from large blocks instead of being allocated piece by
+   piece, and released in one call when the phase ends. Requests larger than a
+   block get a block of their own
+*/
+
+typedef struct arena_block
+{
+  struct arena_block *next;
+  size_t size, used;
+  size_t pad; // keeps data 16-byte aligned
+  unsigned char data[];
+} arena_block;
+
+typedef struct arena
+{
+  arena_block *head; // block being carved, older blocks follow
+  size_t block_size;
+  size_t n_bytes; // bytes handed out
+  size_t n_reserved; // bytes of the blocks
+} arena;
+
+arena* arena_create(size_t block_size);
+void* arena_alloc(arena* pool, size_t bytes);
+void* arena_calloc(arena* pool, size_t bytes);
+void arena_free(arena* pool);
+
+#endif
@@ -0,0 +1,527 @@
+#include "basis.h"
+
+wh_table* wh_table_create(long long int n_states) {
+/* Allocate an empty basis index with room for n_states entries
+
+  Input(s):
+    long long int n_states: number of basis states that will be inserted
+
+  Output(s):
+    wh_table* table: index with every bucket empty
+*/
+  wh_table *table = malloc(sizeof(*table));
+  if (table == NULL) {printf("Error allocating basis index\n"); exit(0);}
+  double n_min = n_states/(WH_BUCKET_SLOTS*WH_LOAD_FACTOR) + 1;
+  int log_n = 1;
+  while ((double) ((uint64_t) 1 << log_n) < n_min) {log_n++;}
+  table->n_buckets = (uint64_t) 1 << log_n;
+  table->mask = table->n_buckets - 1;
+  table->shift = 64 - log_n;
+  table->n_entries = 0;
+  // Each bucket is a cache line, so the array starts on one
+  size_t bytes = (table->n_buckets*sizeof(wh_bucket) + 63) & ~(size_t) 63;
+  table->buckets = aligned_alloc(64, bytes);
+  if (table->buckets == NULL) {printf("Error allocating %llu basis index buckets\n", (unsigned long long) table->n_buckets); exit(0);}
+  memset(table->buckets, 0, table->n_buckets*sizeof(wh_bucket));
+
+  return table;
+}
+
+void wh_table_free(wh_table* table) {
+  if (table == NULL) {return;}
+  free(table->buckets);
+  free(table);
+  return;
+}
+
+void wh_insert(wh_table* table, unsigned int pp, unsigned int pn, basis_int index) {
+/* Insert the basis state (pp, pn) with position index
+   Overflowing buckets spill into the next bucket (linear probing)
+*/
+  if (table->n_entries >= (long long int) (WH_BUCKET_SLOTS*table->n_buckets)) {printf("Error: basis index is full\n"); exit(0);}
+  uint64_t key = wh_key(pp, pn);
+  uint64_t b = wh_bucket_of(table, key);
+  while (table->buckets[b].n_used == WH_BUCKET_SLOTS) {
+    b = (b + 1) & table->mask;
+  }
+  wh_bucket *bucket = &table->buckets[b];
+  bucket->key[bucket->n_used] = key;
+  bucket->index[bucket->n_used] = index;
+  bucket->n_used++;
+  table->n_entries++;
+
+  return;
+}
+
+wh_offsets* wh_offsets_alloc(unsigned int n_sds_p, unsigned int n_sds_n) {
+/* Allocate an offset index with no sectors and no blocks
+*/
+  wh_offsets *offsets = malloc(sizeof(*offsets));
+  if (offsets == NULL) {printf("Error allocating offset index\n"); exit(0);}
+  offsets->n_sds_p = n_sds_p;
+  offsets->n_sds_n = n_sds_n;
+  offsets->n_sectors = 0;
+  offsets->max_sectors = 16;
+  offsets->sector_key = (int*) malloc(sizeof(int)*3*offsets->max_sectors);
+  offsets->sector_size = (long long int*) malloc(sizeof(long long int)*offsets->max_sectors);
+  offsets->base = (long long int*) malloc(sizeof(long long int)*offsets->max_sectors*(n_sds_p + 1));
+  offsets->sector_n = (unsigned short*) calloc(n_sds_n + 1, sizeof(unsigned short));
+  offsets->rank_n = (unsigned int*) malloc(sizeof(unsigned int)*(n_sds_n + 1));
+  if ((offsets->sector_key == NULL) || (offsets->sector_size == NULL) || (offsets->base == NULL) || (offsets->sector_n == NULL) || (offsets->rank_n == NULL)) {printf("Error allocating offset index\n"); exit(0);}
+  memset(offsets->rank_n, 0xFF, sizeof(unsigned int)*(n_sds_n + 1));
+
+  return offsets;
+}
+
+int wh_offsets_sector(wh_offsets* offsets, unsigned int pn, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell) {
+/* Returns the (jz, parity, w) sector of the neutron SD pn, adding a new sector
+   with no blocks if it has not been seen before
+
+  Output(s):
+    int sector: 0-based sector number, -1 if the index has run out of sectors
+*/
+  if (offsets->sector_n[pn] != 0) {return offsets->sector_n[pn] - 1;}
+  int jz = round(2*m_from_p(pn, n_s, n_n, jz_shell));
+  int parity = parity_from_p(pn, n_s, n_n, l_shell);
+  int w = w_from_p(pn, n_s, n_n, w_shell);
+  int sector = 0;
+  int *key = offsets->sector_key;
+  while ((sector < offsets->n_sectors) && ((key[3*sector] != jz) || (key[3*sector + 1] != parity) || (key[3*sector + 2] != w))) {sector++;}
+  if (sector == offsets->n_sectors) {
+    if (sector == 65535) {printf("Too many neutron sectors for the offset index\n"); return -1;}
+    if (sector == offsets->max_sectors) {
+      offsets->max_sectors *= 2;
+      offsets->sector_key = (int*) realloc(offsets->sector_key, sizeof(int)*3*offsets->max_sectors);
+      offsets->sector_size = (long long int*) realloc(offsets->sector_size, sizeof(long long int)*offsets->max_sectors);
+      offsets->base = (long long int*) realloc(offsets->base, sizeof(long long int)*offsets->max_sectors*(offsets->n_sds_p + 1));
+      if ((offsets->sector_key == NULL) || (offsets->sector_size == NULL) || (offsets->base == NULL)) {printf("Error allocating offset index\n"); exit(0);}
+    }
+    offsets->sector_key[3*sector] = jz;
+    offsets->sector_key[3*sector + 1] = parity;
+    offsets->sector_key[3*sector + 2] = w;
+    offsets->sector_size[sector] = 0;
+    memset(&offsets->base[(long long int) sector*(offsets->n_sds_p + 1)], 0xFF, sizeof(long long int)*(offsets->n_sds_p + 1));
+    offsets->n_sectors++;
+  }
+  offsets->sector_n[pn] = sector + 1;
+
+  return sector;
+}
+
+double wh_offsets_memory(wh_offsets* offsets) {
+  // Memory used by the offset index in MB
+  return (sizeof(long long int)*(double) (offsets->n_sds_p + 1)*offsets->n_sectors + (sizeof(unsigned short) + sizeof(unsigned int))*(double) (offsets->n_sds_n + 1))/(1024*1024);
+}
+
+wh_offsets* wh_offsets_create(long long int n_states, unsigned int* pp_state, unsigned int* pn_state, unsigned int n_sds_p, unsigned int n_sds_n, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell) {
+/* Build the proton-block offset index from the basis states in file order
+   The block structure is verified for every state while it is built
+
+  Input(s):
+    long long int n_states: number of basis states
+    unsigned int* pp_state, pn_state: proton and neutron SD of each basis state
+    unsigned int n_sds_p, n_sds_n: number of proton and neutron SDs
+    int n_s: number of single-particle states
+    int n_n: number of neutrons
+    int* jz_shell, l_shell, w_shell: quantum numbers of the single-particle states
+
+  Output(s):
+    wh_offsets* offsets: the index, or NULL if the basis is not made of complete
+                         (proton SD, neutron sector) blocks
+*/
+  wh_offsets *offsets = wh_offsets_alloc(n_sds_p, n_sds_n);
+  for (long long int i = 0; i < n_states; i++) {
+    if (wh_offsets_sector(offsets, pn_state[i], n_s, n_n, jz_shell, l_shell, w_shell) < 0) {
+      wh_offsets_free(offsets);
+      return NULL;
+    }
+  }
+
+  // Walk the runs of consecutive states sharing a proton SD and neutron sector
+  // The first run of each sector fixes the ranks, every later run must repeat it
+  int valid = 1;
+  long long int start = 0;
+  while ((start < n_states) && valid) {
+    unsigned int pp = pp_state[start];
+    int sector = offsets->sector_n[pn_state[start]] - 1;
+    long long int end = start;
+    while ((end < n_states) && (pp_state[end] == pp) && (offsets->sector_n[pn_state[end]] - 1 == sector)) {end++;}
+    long long int *base = &offsets->base[(long long int) sector*(n_sds_p + 1) + pp];
+    if (*base >= 0) {valid = 0; break;}
+    *base = start;
+    if (offsets->sector_size[sector] == 0) {
+      for (long long int i = start; i < end; i++) {
+        if (offsets->rank_n[pn_state[i]] != UINT32_MAX) {valid = 0; break;}
+        offsets->rank_n[pn_state[i]] = i - start;
+      }
+      offsets->sector_size[sector] = end - start;
+    } else {
+      if (end - start != offsets->sector_size[sector]) {valid = 0; break;}
+      for (long long int i = start; i < end; i++) {
+        if (offsets->rank_n[pn_state[i]] != i - start) {valid = 0; break;}
+      }
+    }
+    start = end;
+  }
+  if (!valid) {
+    printf("Basis is not made of complete proton-neutron sector blocks\n");
+    wh_offsets_free(offsets);
+    return NULL;
+  }
+  printf("Offset index: %d neutron sectors, %g MB\n", offsets->n_sectors, wh_offsets_memory(offsets));
+
+  return offsets;
+}
+
+void wh_offsets_free(wh_offsets* offsets) {
+  if (offsets == NULL) {return;}
+  free(offsets->sector_key);
+  free(offsets->sector_size);
+  free(offsets->sector_n);
+  free(offsets->rank_n);
+  free(offsets->base);
+  free(offsets);
+  return;
+}
+
+wh_filter* wh_filter_create(long long int n_states, unsigned int* pp_state, unsigned int* pn_state, unsigned int n_sds_p, unsigned int n_sds_n, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell) {
+/* Builds the existence filter of a basis from its states, for bases that have no offset index
+
+  Output(s):
+    wh_filter* filter: the filter, or NULL if the basis has too many neutron sectors
+*/
+  // Sector the neutron SDs with a scratch offset index and keep only its sector map
+  wh_offsets *sectors = wh_offsets_alloc(n_sds_p, n_sds_n);
+  for (long long int i = 0; i < n_states; i++) {
+    if (wh_offsets_sector(sectors, pn_state[i], n_s, n_n, jz_shell, l_shell, w_shell) < 0) {
+      wh_offsets_free(sectors);
+      return NULL;
+    }
+  }
+  wh_filter *filter = malloc(sizeof(*filter));
+  if (filter == NULL) {printf("Error allocating basis filter\n"); exit(0);}
+  filter->n_sds_p = n_sds_p;
+  filter->n_sds_n = n_sds_n;
+  filter->sector_n = sectors->sector_n;
+  filter->n_lookups = 0;
+  filter->n_rejected = 0;
+  uint64_t n_bits = (uint64_t) sectors->n_sectors*(n_sds_p + 1);
+  filter->bits = (uint64_t*) calloc(n_bits/64 + 1, sizeof(uint64_t));
+  if (filter->bits == NULL) {printf("Error allocating basis filter\n"); exit(0);}
+  for (long long int i = 0; i < n_states; i++) {
+    uint64_t bit = (uint64_t) (filter->sector_n[pn_state[i]] - 1)*(n_sds_p + 1) + pp_state[i];
+    filter->bits[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+  }
+  sectors->sector_n = NULL;
+  wh_offsets_free(sectors);
+
+  return filter;
+}
+
+void wh_filter_free(wh_filter* filter) {
+  if (filter == NULL) {return;}
+  free(filter->sector_n);
+  free(filter->bits);
+  free(filter);
+  return;
+}
+
+basis_index* basis_index_from_offsets(wh_offsets* offsets) {
+/* Wraps an offset index that has already been built
+*/
+  basis_index *basis = malloc(sizeof(*basis));
+  if (basis == NULL) {printf("Error allocating basis index\n"); exit(0);}
+  basis->mode = BASIS_LOOKUP_OFFSET;
+  basis->table = NULL;
+  basis->offsets = offsets;
+  basis->filter = NULL;
+  basis->n_sorted = 0;
+  basis->sorted_key = NULL;
+  basis->sorted_index = NULL;
+
+  return basis;
+}
+
+basis_index* basis_index_create(long long int n_states, unsigned int* pp_state, unsigned int* pn_state, unsigned int n_sds_p, unsigned int n_sds_n, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell, int mode) {
+/* Build the basis index in the requested lookup mode
+   The offset mode falls back to the hash table if the basis is not block-structured
+*/
+  basis_index *basis = malloc(sizeof(*basis));
+  basis->mode = mode;
+  basis->table = NULL;
+  basis->offsets = NULL;
+  basis->filter = NULL;
+  basis->n_sorted = 0;
+  basis->sorted_key = NULL;
+  basis->sorted_index = NULL;
+  if (mode == BASIS_LOOKUP_OFFSET) {
+    basis->offsets = wh_offsets_create(n_states, pp_state, pn_state, n_sds_p, n_sds_n, n_s, n_n, jz_shell, l_shell, w_shell);
+    if (basis->offsets == NULL) {
+      printf("Falling back to hashed basis lookups\n");
+      basis->mode = BASIS_LOOKUP_HASH;
+    }
+  }
+  if (basis->mode == BASIS_LOOKUP_HASH) {
+    basis->table = wh_table_create(n_states);
+    for (long long int i = 0; i < n_states; i++) {
+      wh_insert(basis->table, pp_state[i], pn_state[i], i);
+    }
+  }
+  // The offset index already rejects absent states from its sectors and block bases
+  if (BASIS_FILTER && (basis->mode == BASIS_LOOKUP_HASH)) {
+    basis->filter = wh_filter_create(n_states, pp_state, pn_state, n_sds_p, n_sds_n, n_s, n_n, jz_shell, l_shell, w_shell);
+  }
+
+  return basis;
+}
+
+void basis_index_free(basis_index* basis) {
+  if (basis == NULL) {return;}
+  wh_table_free(basis->table);
+  wh_filter_free(basis->filter);
+  wh_offsets_free(basis->offsets);
+  free(basis->sorted_key);
+  free(basis->sorted_index);
+  free(basis);
+  return;
+}
+
+void wh_filter_count(wh_filter* filter, int maybe) {
+  // Counts a lookup and whether the filter rejected it, stats builds only (BASIS_FILTER_STATS)
+  #pragma omp atomic
+  filter->n_lookups++;
+  if (!maybe) {
+    #pragma omp atomic
+    filter->n_rejected++;
+  }
+  return;
+}
+
+void basis_filter_report(basis_index* basis, char* label) {
+  // Prints how many lookups of the basis were rejected by its existence filter
+  if (!BASIS_FILTER_STATS || (basis == NULL) || (basis->filter == NULL)) {return;}
+  wh_filter *filter = basis->filter;
+  printf("%s basis filter: rejected %lld of %lld lookups (%g%%)\n", label, filter->n_rejected, filter->n_lookups, (filter->n_lookups > 0) ? 100.0*filter->n_rejected/filter->n_lookups : 0.0);
+  return;
+}
+
+void basis_present_sds(basis_index* basis, unsigned char* present_p, unsigned char* present_n) {
+/* Marks the proton and neutron SDs that occur in at least one basis state
+   present_p and present_n are indexed by SD (1-based) and must be zeroed by the caller
+*/
+  if (basis->mode == BASIS_LOOKUP_OFFSET) {
+    wh_offsets *offsets = basis->offsets;
+    long long int row = offsets->n_sds_p + 1;
+    for (int s = 0; s < offsets->n_sectors; s++) {
+      for (unsigned int pp = 1; pp <= offsets->n_sds_p; pp++) {
+        if (offsets->base[s*row + pp] >= 0) {present_p[pp] = 1;}
+      }
+    }
+    for (unsigned int pn = 1; pn <= offsets->n_sds_n; pn++) {
+      if (offsets->sector_n[pn] != 0) {present_n[pn] = 1;}
+    }
+  } else {
+    wh_table *table = basis->table;
+    for (uint64_t b = 0; b < table->n_buckets; b++) {
+      for (unsigned int k = 0; k < table->buckets[b].n_used; k++) {
+        present_p[table->buckets[b].key[k] >> 32] = 1;
+        present_n[table->buckets[b].key[k] & 0xFFFFFFFF] = 1;
+      }
+    }
+  }
+
+  return;
+}
+
+int basis_renumber(basis_index* basis, int n_coef, float** bc, int* n_eig) {
+/* Renumbers the basis states in the order the trace kernels visit them: all states of a
+   proton SD together, in increasing proton SD, with the neutron sectors of each proton SD
+   ordered by (parity, jz, w). Neutron SDs keep their order within a sector, so the offset
+   index only needs new block bases. The coefficient rows are permuted to match
+
+  Input(s):
+    int n_coef: number of coefficient arrays on this basis
+    float** bc: coefficient arrays, bc[k][e + n_eig[k]*index], replaced by permuted copies
+    int* n_eig: number of eigenstates in each array
+
+  Output(s):
+    int renumbered: 1 if the basis was renumbered, 0 if it has no offset index
+*/
+  if (basis->mode != BASIS_LOOKUP_OFFSET) {return 0;}
+  wh_offsets *offsets = basis->offsets;
+  int n_sectors = offsets->n_sectors;
+  long long int row = offsets->n_sds_p + 1;
+
+  // Order the neutron sectors by parity, then jz, then w
+  int *sector_order = (int*) malloc(sizeof(int)*n_sectors);
+  for (int s = 0; s < n_sectors; s++) {sector_order[s] = s;}
+  int *key = offsets->sector_key;
+  for (int s = 1; s < n_sectors; s++) {
+    int t = sector_order[s];
+    int k = s;
+    while (k > 0) {
+      int u = sector_order[k - 1];
+      int before = (key[3*t + 1] != key[3*u + 1]) ? (key[3*t + 1] < key[3*u + 1]) : ((key[3*t] != key[3*u]) ? (key[3*t] < key[3*u]) : (key[3*t + 2] < key[3*u + 2]));
+      if (!before) {break;}
+      sector_order[k] = u;
+      k--;
+    }
+    sector_order[k] = t;
+  }
+
+  long long int *new_base = (long long int*) malloc(sizeof(long long int)*n_sectors*row);
+  if (new_base == NULL) {printf("Error allocating basis renumbering\n"); exit(0);}
+  memset(new_base, 0xFF, sizeof(long long int)*n_sectors*row);
+  long long int n_states = 0;
+  for (unsigned int pp = 1; pp <= offsets->n_sds_p; pp++) {
+    for (int k = 0; k < n_sectors; k++) {
+      int s = sector_order[k];
+      if (offsets->base[s*row + pp] < 0) {continue;}
+      new_base[s*row + pp] = n_states;
+      n_states += offsets->sector_size[s];
+    }
+  }
+
+  for (int c = 0; c < n_coef; c++) {
+    float *bc_new = (float*) malloc(sizeof(float)*n_eig[c]*n_states);
+    if (bc_new == NULL) {printf("Error allocating renumbered coefficients\n"); exit(0);}
+    for (long long int b = 0; b < n_sectors*row; b++) {
+      if (offsets->base[b] < 0) {continue;}
+      long long int size = offsets->sector_size[b/row];
+      memcpy(&bc_new[n_eig[c]*new_base[b]], &bc[c][n_eig[c]*offsets->base[b]], sizeof(float)*n_eig[c]*size);
+    }
+    free(bc[c]);
+    bc[c] = bc_new;
+  }
+  free(offsets->base);
+  offsets->base = new_base;
+  offsets->max_sectors = n_sectors;
+  free(sector_order);
+
+  // Keys sorted for the merge-join lookups carry the old numbering
+  free(basis->sorted_key);
+  free(basis->sorted_index);
+  basis->sorted_key = NULL;
+  basis->sorted_index = NULL;
+  basis->n_sorted = 0;
+  printf("Renumbered %lld basis states in proton SD order\n", n_states);
+
+  return 1;
+}
+
+int wh_query_compare(const void* a, const void* b) {
+  uint64_t key_a = ((const wh_query*) a)->key;
+  uint64_t key_b = ((const wh_query*) b)->key;
+  return (key_a > key_b) - (key_a < key_b);
+}
+
+void basis_sort_keys(basis_index* basis) {
+/* Lists every basis state as a (pp << 32 | pn) key with its index, sorted by key
+   The states are recovered from whichever index the basis was loaded with
+*/
+  if (basis->sorted_key != NULL) {return;}
+  long long int n_states = 0;
+  wh_query *state = NULL;
+  if (basis->mode == BASIS_LOOKUP_HASH) {
+    wh_table *table = basis->table;
+    n_states = table->n_entries;
+    state = (wh_query*) malloc(sizeof(wh_query)*n_states);
+    long long int i = 0;
+    for (uint64_t b = 0; b < table->n_buckets; b++) {
+      for (unsigned int k = 0; k < table->buckets[b].n_used; k++) {
+        state[i].key = table->buckets[b].key[k];
+        state[i].pos = table->buckets[b].index[k];
+        i++;
+      }
+    }
+  } else {
+    // Neutron SDs of each sector in rank order, then every (sector, pp) block
+    wh_offsets *offsets = basis->offsets;
+    int n_sectors = offsets->n_sectors;
+    long long int *sector_start = (long long int*) malloc(sizeof(long long int)*(n_sectors + 1));
+    sector_start[0] = 0;
+    for (int s = 0; s < n_sectors; s++) {sector_start[s + 1] = sector_start[s] + offsets->sector_size[s];}
+    unsigned int *pn_of_rank = (unsigned int*) malloc(sizeof(unsigned int)*(sector_start[n_sectors] + 1));
+    for (unsigned int pn = 1; pn <= offsets->n_sds_n; pn++) {
+      int s = offsets->sector_n[pn];
+      if ((s == 0) || (offsets->rank_n[pn] == UINT32_MAX)) {continue;}
+      pn_of_rank[sector_start[s - 1] + offsets->rank_n[pn]] = pn;
+    }
+    for (int s = 0; s < n_sectors; s++) {
+      for (unsigned int pp = 1; pp <= offsets->n_sds_p; pp++) {
+        if (offsets->base[(long long int) s*(offsets->n_sds_p + 1) + pp] >= 0) {n_states += offsets->sector_size[s];}
+      }
+    }
+    state = (wh_query*) malloc(sizeof(wh_query)*n_states);
+    long long int i = 0;
+    for (int s = 0; s < n_sectors; s++) {
+      for (unsigned int pp = 1; pp <= offsets->n_sds_p; pp++) {
+        long long int base = offsets->base[(long long int) s*(offsets->n_sds_p + 1) + pp];
+        if (base < 0) {continue;}
+        for (long long int r = 0; r < offsets->sector_size[s]; r++) {
+          state[i].key = wh_key(pp, pn_of_rank[sector_start[s] + r]);
+          state[i].pos = base + r;
+          i++;
+        }
+      }
+    }
+    free(sector_start);
+    free(pn_of_rank);
+  }
+  qsort(state, n_states, sizeof(wh_query), wh_query_compare);
+  basis->n_sorted = n_states;
+  basis->sorted_key = (uint64_t*) malloc(sizeof(uint64_t)*(n_states + 1));
+  basis->sorted_index = (basis_int*) malloc(sizeof(basis_int)*(n_states + 1));
+  if ((basis->sorted_key == NULL) || (basis->sorted_index == NULL)) {printf("Error allocating sorted basis keys\n"); exit(0);}
+  for (long long int i = 0; i < n_states; i++) {
+    basis->sorted_key[i] = state[i].key;
+    basis->sorted_index[i] = state[i].pos;
+  }
+  free(state);
+  printf("Sorted basis keys: %lld states, %g MB\n", n_states, (sizeof(uint64_t) + sizeof(basis_int))*(double) n_states/(1024*1024));
+
+  return;
+}
+
+void basis_lookup_sorted(basis_index* basis, long long int n_query, wh_query* query, basis_int* index) {
+/* Resolves a batch of lookups by sorting the queries and merging them with the
+   sorted basis keys. The basis cursor only moves forward, skipping ahead by
+   galloping search, so the basis array is read as a stream
+
+  Input(s):
+    wh_query* query: keys to look up, query[k].pos is where the result goes.
+                     The array is reordered
+  Output(s):
+    basis_int* index: index[query[k].pos] is the basis index of the key, -1 if absent
+*/
+  basis_sort_keys(basis);
+  qsort(query, n_query, sizeof(wh_query), wh_query_compare);
+  long long int n = basis->n_sorted;
+  uint64_t *sorted_key = basis->sorted_key;
+  long long int cur = 0;
+  for (long long int k = 0; k < n_query; k++) {
+    uint64_t key = query[k].key;
+    if ((cur < n) && (sorted_key[cur] < key)) {
+      // Gallop to a bracket (lo, hi] holding the first key >= key, then bisect
+      long long int lo = cur;
+      long long int step = 1;
+      while ((lo + step < n) && (sorted_key[lo + step] < key)) {
+        lo += step;
+        step *= 2;
+      }
+      long long int hi = MIN(lo + step, n);
+      while (hi - lo > 1) {
+        long long int mid = lo + (hi - lo)/2;
+        if (sorted_key[mid] < key) {lo = mid;} else {hi = mid;}
+      }
+      cur = hi;
+    }
+    if ((cur < n) && (sorted_key[cur] == key)) {
+      index[query[k].pos] = basis->sorted_index[cur];
+    } else {
+      index[query[k].pos] = -1;
+    }
+  }
+
+  return;
+}
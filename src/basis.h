@@ -0,0 +1,174 @@
+#ifndef BASIS_H
+#define BASIS_H
+#include "slater.h"
+
+/* Open-addressing index of the many-body basis
+   Each basis state is a product of a proton SD (pp) and a neutron SD (pn)
+   The table maps (pp, pn) to the position of the state in the BIGSTICK basis
+   Slots are packed into cache-line-sized buckets (5 keys, 5 indices and a count)
+   and full buckets spill into the next one, so a lookup touches one line in the
+   common case
+*/
+
+/* Basis state indices
+   Coefficients are addressed as bc[eig + n_eig*index], so the 32-bit type is only
+   used when n_states*n_eig fits in an int (checked when the wavefunction is read)
+*/
+#if BASIS_INDEX_64
+typedef long long int basis_int;
+#define BASIS_INDEX_MAX LLONG_MAX
+#define WH_BUCKET_SLOTS 3
+#else
+typedef int basis_int;
+#define BASIS_INDEX_MAX INT_MAX
+#define WH_BUCKET_SLOTS 5
+#endif
+
+// Lookup modes of the basis index
+#define BASIS_LOOKUP_HASH 0
+#define BASIS_LOOKUP_OFFSET 1
+
+// One cache line: 5 slots fill it with 32-bit indices, 3 slots and padding with 64-bit ones
+typedef struct wh_bucket
+{
+  _Alignas(64) uint64_t key[WH_BUCKET_SLOTS]; // (pp << 32) | pn, zero marks an empty slot
+  basis_int index[WH_BUCKET_SLOTS];
+  unsigned int n_used;
+} wh_bucket;
+
+typedef struct wh_table
+{
+  wh_bucket *buckets;
+  uint64_t n_buckets, mask;
+  int shift;
+  long long int n_entries;
+} wh_table;
+
+/* Proton-block offset index
+   BIGSTICK stores the basis as blocks of (proton SD, neutron sector) pairs, where a neutron
+   sector is the set of neutron SDs with a given (jz, parity, w) and every block lists the
+   whole sector in the same order. The index of a state is then
+     index = base[sector(pn)][pp] + rank(pn)
+   which is two dense array reads and no hashing
+*/
+typedef struct wh_offsets
+{
+  unsigned int n_sds_p, n_sds_n;
+  int n_sectors, max_sectors;
+  int *sector_key; // (2 jz, parity, w) of each neutron sector
+  long long int *sector_size; // number of neutron SDs in each sector, 0 until its first block is read
+  unsigned short *sector_n; // 1 + neutron sector of each neutron SD, 0 if the SD is not in the basis
+  unsigned int *rank_n; // position of each neutron SD within its sector
+  long long int *base; // index of the first state of each (neutron sector, proton SD) block, -1 if absent
+} wh_offsets;
+
+/* Existence filter of a hashed basis
+   One bit per (neutron sector, proton SD) block, set if the block is in the basis.
+   Pairs of SDs outside the truncated space are rejected from the bitmap before
+   the hash table is probed. The offset index needs no filter, its sector map and
+   block bases answer the same question
+*/
+typedef struct wh_filter
+{
+  unsigned int n_sds_p, n_sds_n;
+  unsigned short *sector_n; // 1 + neutron sector of each neutron SD, 0 if the SD is not in the basis
+  uint64_t *bits;
+  long long int n_lookups, n_rejected; // counted only when BASIS_FILTER_STATS is set
+} wh_filter;
+
+typedef struct basis_index
+{
+  int mode;
+  wh_table *table;
+  wh_offsets *offsets;
+  wh_filter *filter; // NULL if lookups are not filtered
+  // Basis keys in increasing order with their indices, built on first use by the merge-join lookups
+  long long int n_sorted;
+  uint64_t *sorted_key;
+  basis_int *sorted_index;
+} basis_index;
+
+// A batched lookup: key of the state and position of the query in the caller's stream
+typedef struct wh_query
+{
+  uint64_t key;
+  long long int pos;
+} wh_query;
+
+wh_table* wh_table_create(long long int n_states);
+void wh_table_free(wh_table* table);
+void wh_insert(wh_table* table, unsigned int pp, unsigned int pn, basis_int index);
+wh_offsets* wh_offsets_alloc(unsigned int n_sds_p, unsigned int n_sds_n);
+int wh_offsets_sector(wh_offsets* offsets, unsigned int pn, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell);
+double wh_offsets_memory(wh_offsets* offsets);
+wh_offsets* wh_offsets_create(long long int n_states, unsigned int* pp_state, unsigned int* pn_state, unsigned int n_sds_p, unsigned int n_sds_n, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell);
+void wh_offsets_free(wh_offsets* offsets);
+wh_filter* wh_filter_create(long long int n_states, unsigned int* pp_state, unsigned int* pn_state, unsigned int n_sds_p, unsigned int n_sds_n, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell);
+void wh_filter_free(wh_filter* filter);
+void wh_filter_count(wh_filter* filter, int maybe);
+basis_index* basis_index_from_offsets(wh_offsets* offsets);
+basis_index* basis_index_create(long long int n_states, unsigned int* pp_state, unsigned int* pn_state, unsigned int n_sds_p, unsigned int n_sds_n, int n_s, int n_n, int* jz_shell, int* l_shell, int* w_shell, int mode);
+void basis_index_free(basis_index* basis);
+void basis_filter_report(basis_index* basis, char* label);
+void basis_present_sds(basis_index* basis, unsigned char* present_p, unsigned char* present_n);
+int basis_renumber(basis_index* basis, int n_coef, float** bc, int* n_eig);
+int wh_query_compare(const void* a, const void* b);
+void basis_sort_keys(basis_index* basis);
+void basis_lookup_sorted(basis_index* basis, long long int n_query, wh_query* query, basis_int* index);
+
+static inline uint64_t wh_key(unsigned int pp, unsigned int pn) {
+  return ((uint64_t) pp << 32) | pn;
+}
+
+static inline uint64_t wh_bucket_of(const wh_table* table, uint64_t key) {
+  // Fibonacci hashing, the top bits of the product select the bucket
+  return (key*0x9E3779B97F4A7C15ULL) >> table->shift;
+}
+
+static inline basis_int wh_lookup(const wh_table* table, unsigned int pp, unsigned int pn) {
+/* Returns the basis index of the state (pp, pn), or -1 if it is not in the basis
+   All slots of a bucket are compared so the inner loop has a fixed trip count
+*/
+  uint64_t key = wh_key(pp, pn);
+  uint64_t b = wh_bucket_of(table, key);
+  while (1) {
+    const wh_bucket *bucket = &table->buckets[b];
+    for (int i = 0; i < WH_BUCKET_SLOTS; i++) {
+      if (bucket->key[i] == key) {return bucket->index[i];}
+    }
+    if (bucket->n_used < WH_BUCKET_SLOTS) {return -1;}
+    b = (b + 1) & table->mask;
+  }
+}
+
+static inline basis_int wh_offsets_lookup(const wh_offsets* offsets, unsigned int pp, unsigned int pn) {
+/* Returns the basis index of the state (pp, pn), or -1 if it is not in the basis
+   Out-of-range SDs are treated as absent, as in the hash
+*/
+  if ((pp > offsets->n_sds_p) || (pn > offsets->n_sds_n)) {return -1;}
+  int sector = offsets->sector_n[pn];
+  if (sector == 0) {return -1;}
+  long long int base = offsets->base[(long long int) (sector - 1)*(offsets->n_sds_p + 1) + pp];
+  if (base < 0) {return -1;}
+  return base + offsets->rank_n[pn];
+}
+
+static inline int wh_filter_test(const wh_filter* filter, unsigned int pp, unsigned int pn) {
+/* Returns 0 if the state (pp, pn) is certainly not in the basis, 1 if it may be
+*/
+  if ((pp > filter->n_sds_p) || (pn > filter->n_sds_n) || (filter->sector_n[pn] == 0)) {return 0;}
+  uint64_t bit = (uint64_t) (filter->sector_n[pn] - 1)*(filter->n_sds_p + 1) + pp;
+  return (filter->bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+static inline basis_int basis_lookup(const basis_index* basis, unsigned int pp, unsigned int pn) {
+  if (basis->filter != NULL) {
+    int maybe = wh_filter_test(basis->filter, pp, pn);
+    if (BASIS_FILTER_STATS) {wh_filter_count(basis->filter, maybe);}
+    if (!maybe) {return -1;}
+  }
+  if (basis->mode == BASIS_LOOKUP_OFFSET) {return wh_offsets_lookup(basis->offsets, pp, pn);}
+  return wh_lookup(basis->table, pp, pn);
+}
+
+#endif
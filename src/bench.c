@@ -0,0 +1,682 @@
+#include "bench.h"
+
+/* Microbenchmarks for the hot paths of the density code
+   Run with: SpeED-DMG <parameter file> bench
+   The wavefunction files named in the parameter file supply the basis
+*/
+
+void run_benchmarks(speedParams* sp) {
+  char wfn_file_initial[100];
+  strcpy(wfn_file_initial, sp->initial_file_base);
+  strcat(wfn_file_initial, ".wfn");
+  char wfn_file_final[100];
+  strcpy(wfn_file_final, sp->final_file_base);
+  strcat(wfn_file_final, ".wfn");
+  char basis_file_initial[100];
+  strcpy(basis_file_initial, sp->initial_file_base);
+  strcat(basis_file_initial, ".bas");
+  char basis_file_final[100];
+  strcpy(basis_file_final, sp->final_file_base);
+  strcat(basis_file_final, ".bas");
+  wfnData *wd = read_binary_wfn_data(wfn_file_initial, wfn_file_final, basis_file_initial, basis_file_final);
+
+  benchmark_basis_lookup(wd, basis_file_initial);
+  benchmark_binomial(wd);
+  benchmark_sd_decode(wd, wd->n_proton_i, "proton");
+  benchmark_sd_decode(wd, wd->n_neutron_i, "neutron");
+  benchmark_annihilation(wd, wd->n_proton_i, "proton");
+  benchmark_annihilation(wd, wd->n_neutron_i, "neutron");
+  benchmark_one_body_hops(wd);
+  benchmark_two_body_trace(wd);
+  benchmark_jump_compress(wd);
+  wfn_data_free(wd);
+
+  return;
+}
+
+void benchmark_basis_lookup(wfnData* wd, char* basis_file) {
+/* Compare lookups per second of the basis index modes against the chained
+   wh_list hash they replaced
+   Half of the queries hit a state in the basis, the rest are random (pp, pn)
+   pairs, most of which miss, as happens in the trace kernels
+*/
+  long long int n_states = wd->n_states_i;
+  unsigned int *pp_state = (unsigned int*) malloc(sizeof(unsigned int)*n_states);
+  unsigned int *pn_state = (unsigned int*) malloc(sizeof(unsigned int)*n_states);
+  read_basis_file(basis_file, wd->n_shells, wd->n_proton_i, wd->n_neutron_i, n_states, pp_state, pn_state, NULL, NULL, NULL, NULL, NULL);
+  wh_list **wh_hash = (wh_list**) calloc(checked_count(wd->n_sds_p_i, HASH_SIZE, 1), sizeof(wh_list*));
+  for (long long int i = 0; i < n_states; i++) {
+    size_t p_hash = pp_state[i] + (size_t) wd->n_sds_p_i*(pn_state[i] % HASH_SIZE);
+    if (wh_hash[p_hash] == NULL) {
+      wh_hash[p_hash] = create_wh_node(pp_state[i], pn_state[i], i, NULL);
+    } else {
+      wh_append(wh_hash[p_hash], pp_state[i], pn_state[i], i);
+    }
+  }
+  basis_index *hash = basis_index_create(n_states, pp_state, pn_state, wd->n_sds_p_i, wd->n_sds_n_i, wd->n_shells, wd->n_neutron_i, wd->jz_shell, wd->l_shell, wd->w_shell, BASIS_LOOKUP_HASH);
+  basis_index *offsets = basis_index_create(n_states, pp_state, pn_state, wd->n_sds_p_i, wd->n_sds_n_i, wd->n_shells, wd->n_neutron_i, wd->jz_shell, wd->l_shell, wd->w_shell, BASIS_LOOKUP_OFFSET);
+
+  unsigned int *pp_query = (unsigned int*) malloc(sizeof(unsigned int)*BENCH_LOOKUPS);
+  unsigned int *pn_query = (unsigned int*) malloc(sizeof(unsigned int)*BENCH_LOOKUPS);
+  srand(BENCH_SEED);
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    if (i % 2 == 0) {
+      long long int j = ((long long int) rand()*RAND_MAX + rand()) % n_states;
+      pp_query[i] = pp_state[j];
+      pn_query[i] = pn_state[j];
+    } else {
+      pp_query[i] = 1 + rand() % wd->n_sds_p_i;
+      pn_query[i] = 1 + rand() % wd->n_sds_n_i;
+    }
+  }
+
+  clock_t start = clock();
+  long long int sum_chain = 0;
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    unsigned int pp = pp_query[i];
+    unsigned int pn = pn_query[i];
+    wh_list *node = wh_hash[pp + (size_t) wd->n_sds_p_i*(pn % HASH_SIZE)];
+    int index = -1;
+    while (node != NULL) {
+      if ((pn == node->pn) && (pp == node->pp)) {
+        index = node->index;
+        break;
+      }
+      node = node->next;
+    }
+    sum_chain += index;
+  }
+  double t_chain = ((double) (clock() - start))/CLOCKS_PER_SEC;
+
+  start = clock();
+  long long int sum_table = 0;
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    sum_table += basis_lookup(hash, pp_query[i], pn_query[i]);
+  }
+  double t_table = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  if (sum_chain != sum_table) {printf("Error: basis index disagrees with chained hash\n"); exit(0);}
+
+  printf("Basis lookup benchmark: %d lookups over %lld states\n", BENCH_LOOKUPS, n_states);
+  double mem_chain = (sizeof(wh_list*)*(double) wd->n_sds_p_i*HASH_SIZE + sizeof(wh_list)*(double) n_states)/(1024*1024);
+  double mem_table = sizeof(wh_bucket)*(double) hash->table->n_buckets/(1024*1024);
+  printf("  chained hash:    %g lookups/sec, %g MB\n", BENCH_LOOKUPS/t_chain, mem_chain);
+  printf("  open addressing: %g lookups/sec, %g MB (%llu buckets, load %g)\n", BENCH_LOOKUPS/t_table, mem_table, (unsigned long long) hash->table->n_buckets, (double) n_states/(WH_BUCKET_SLOTS*hash->table->n_buckets));
+
+  if (offsets->mode == BASIS_LOOKUP_OFFSET) {
+    start = clock();
+    long long int sum_offset = 0;
+    for (int i = 0; i < BENCH_LOOKUPS; i++) {
+      sum_offset += basis_lookup(offsets, pp_query[i], pn_query[i]);
+    }
+    double t_offset = ((double) (clock() - start))/CLOCKS_PER_SEC;
+    if (sum_chain != sum_offset) {printf("Error: offset index disagrees with chained hash\n"); exit(0);}
+    double mem_offset = wh_offsets_memory(offsets->offsets);
+    printf("  proton offsets:  %g lookups/sec, %g MB (%d neutron sectors)\n", BENCH_LOOKUPS/t_offset, mem_offset, offsets->offsets->n_sectors);
+  } else {
+    printf("  proton offsets:  not available for this basis\n");
+  }
+
+  for (size_t i = 0; i < (size_t) wd->n_sds_p_i*HASH_SIZE; i++) {
+    wh_list *node = wh_hash[i];
+    while (node != NULL) {
+      wh_list *next = node->next;
+      free(node);
+      node = next;
+    }
+  }
+  free(wh_hash);
+  free(pp_query);
+  free(pn_query);
+  free(pp_state);
+  free(pn_state);
+  basis_index_free(hash);
+  basis_index_free(offsets);
+
+  return;
+}
+
+void benchmark_binomial(wfnData* wd) {
+/* Binomial coefficients per second from the precomputed table against the
+   gsl_sf_choose path it replaced, cycling over every C(n, k) with n up to the
+   number of single-particle states. Also counts the coefficients on which the
+   double-precision gsl result, truncated to an integer, is not exact
+*/
+  int ns = wd->n_shells;
+  int n_pairs = (ns + 1)*(ns + 2)/2;
+  int *n_arg = (int*) malloc(sizeof(int)*n_pairs);
+  int *k_arg = (int*) malloc(sizeof(int)*n_pairs);
+  int i_pair = 0;
+  int n_inexact = 0;
+  for (int n = 0; n <= ns; n++) {
+    for (int k = 0; k <= n; k++) {
+      n_arg[i_pair] = n;
+      k_arg[i_pair] = k;
+      if (n_choose_k_gsl(n, k) != n_choose_k(n, k)) {n_inexact++;}
+      i_pair++;
+    }
+  }
+
+  clock_t start = clock();
+  unsigned long long int sum_gsl = 0;
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    sum_gsl += n_choose_k_gsl(n_arg[i % n_pairs], k_arg[i % n_pairs]);
+  }
+  double t_gsl = ((double) (clock() - start))/CLOCKS_PER_SEC;
+
+  start = clock();
+  unsigned long long int sum_table = 0;
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    sum_table += n_choose_k(n_arg[i % n_pairs], k_arg[i % n_pairs]);
+  }
+  double t_table = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  if ((n_inexact == 0) && (sum_gsl != sum_table)) {printf("Error: binomial table disagrees with gsl\n"); exit(0);}
+
+  printf("Binomial benchmark: %d coefficients with n <= %d, %d evaluations\n", n_pairs, ns, BENCH_LOOKUPS);
+  printf("  gsl_sf_choose: %g per sec (%d coefficients not exact)\n", BENCH_LOOKUPS/t_gsl, n_inexact);
+  printf("  table:         %g per sec\n", BENCH_LOOKUPS/t_table);
+  free(n_arg);
+  free(k_arg);
+
+  return;
+}
+
+void benchmark_sd_decode(wfnData* wd, int n_p, char* label) {
+/* Per-SD cost of decoding the quantum numbers the jump builders need, with the
+   separate j_min_from_p, w_from_p, m_from_p, parity_from_p and get_m_pi_q calls,
+   the single-pass decode_sd and the incremental sd_walk
+   SDs are decoded in p order, cycling until BENCH_DECODES have been done
+*/
+  if (n_p <= 0) {return;}
+  int ns = wd->n_shells;
+  unsigned int n_sds = get_num_sds(ns, n_p);
+
+  clock_t start = clock();
+  long long int sum_separate = 0;
+  for (int i = 0; i < BENCH_DECODES; i++) {
+    unsigned int p = 1 + i % n_sds;
+    int j_min = j_min_from_p(ns, n_p, p);
+    int w = w_from_p(p, ns, n_p, wd->w_shell);
+    float mj = m_from_p(p, ns, n_p, wd->jz_shell);
+    int parity = parity_from_p(p, ns, n_p, wd->l_shell);
+    float mj_q;
+    int parity_q, n_quanta;
+    get_m_pi_q(p, ns, n_p, wd->n_shell, wd->l_shell, wd->jz_shell, &mj_q, &parity_q, &n_quanta, j_min);
+    sum_separate += j_min + w + (long long int) (2*mj) + parity + n_quanta;
+  }
+  double t_separate = ((double) (clock() - start))/CLOCKS_PER_SEC;
+
+  start = clock();
+  long long int sum_single = 0;
+  for (int i = 0; i < BENCH_DECODES; i++) {
+    unsigned int p = 1 + i % n_sds;
+    sd_info sd;
+    decode_sd(p, ns, n_p, wd->n_shell, wd->l_shell, wd->jz_shell, wd->w_shell, NULL, &sd);
+    sum_single += sd.j_min + sd.w + (long long int) (2*sd.mj) + sd.parity + sd.n_quanta;
+  }
+  double t_single = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  if (sum_separate != sum_single) {printf("Error: decode_sd disagrees with the separate decoders\n"); exit(0);}
+
+  start = clock();
+  long long int sum_walk = 0;
+  sd_walk walk;
+  sd_walk_start(&walk, ns, n_p, wd->n_shell, wd->l_shell, wd->jz_shell, wd->w_shell);
+  for (int i = 0; i < BENCH_DECODES; i++) {
+    if (walk.p == 0) {
+      sd_walk_free(&walk);
+      sd_walk_start(&walk, ns, n_p, wd->n_shell, wd->l_shell, wd->jz_shell, wd->w_shell);
+    }
+    sum_walk += walk.sd.j_min + walk.sd.w + (long long int) (2*walk.sd.mj) + walk.sd.parity + walk.sd.n_quanta;
+    sd_walk_next(&walk);
+  }
+  sd_walk_free(&walk);
+  double t_walk = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  if (sum_separate != sum_walk) {printf("Error: sd_walk disagrees with the separate decoders\n"); exit(0);}
+
+  printf("SD decode benchmark: %u %s SDs (%d particles), %d decodes\n", n_sds, label, n_p, BENCH_DECODES);
+  printf("  separate decoders: %g ns/SD\n", 1e9*t_separate/BENCH_DECODES);
+  printf("  decode_sd:         %g ns/SD\n", 1e9*t_single/BENCH_DECODES);
+  printf("  sd_walk:           %g ns/SD\n", 1e9*t_walk/BENCH_DECODES);
+
+  return;
+}
+
+void benchmark_annihilation(wfnData* wd, int n_p, char* label) {
+/* Acts every annihilation operator on every SD with the Whitehead walk of a_op
+   and with occupation masks, checking that both give the same SD and phase for
+   every (SD, orbital) pair before timing them
+*/
+  int ns = wd->n_shells;
+  int n_words = sd_mask_words(ns);
+  if ((n_p <= 0) || (n_words == 0)) {return;}
+  unsigned int n_sds = get_num_sds(ns, n_p);
+  unsigned int *p_sd = (unsigned int*) malloc(sizeof(unsigned int)*n_sds);
+  sd_bits *mask_sd = (sd_bits*) malloc(sizeof(sd_bits)*n_sds);
+  int *j_min_sd = (int*) malloc(sizeof(int)*n_sds);
+  sd_walk walk;
+  sd_walk_start(&walk, ns, n_p, NULL, NULL, NULL, NULL);
+  for (unsigned int i = 0; i < n_sds; i++) {
+    p_sd[i] = walk.p;
+    mask_sd[i] = walk.mask;
+    j_min_sd[i] = walk.sd.j_min;
+    sd_walk_next(&walk);
+  }
+  sd_walk_free(&walk);
+  for (unsigned int i = 0; i < n_sds; i++) {
+    for (int a = j_min_sd[i]; a <= ns; a++) {
+      int phase_walk = 0, phase_mask = 0;
+      sd_bits mask_f;
+      unsigned int pf_walk = a_op(ns, n_p, p_sd[i], a, &phase_walk, j_min_sd[i]);
+      unsigned int pf_mask = sd_mask_annihilate(ns, n_p, &mask_sd[i], n_words, a, &phase_mask, &mask_f);
+      if ((pf_walk != pf_mask) || ((pf_walk != 0) && (phase_walk != phase_mask))) {
+        printf("Error: mask annihilation of orbital %d on %s SD %u gives %u with phase %d, a_op gives %u with phase %d\n", a, label, p_sd[i], pf_mask, phase_mask, pf_walk, phase_walk);
+        exit(0);
+      }
+    }
+  }
+  int n_rep = BENCH_DECODES/n_sds + 1;
+
+  clock_t start = clock();
+  long long int sum_walk = 0;
+  for (int r = 0; r < n_rep; r++) {
+    for (unsigned int i = 0; i < n_sds; i++) {
+      for (int a = j_min_sd[i]; a <= ns; a++) {
+        int phase;
+        unsigned int pf = a_op(ns, n_p, p_sd[i], a, &phase, j_min_sd[i]);
+        if (pf != 0) {sum_walk += phase*(long long int) pf;}
+      }
+    }
+  }
+  double t_walk = ((double) (clock() - start))/CLOCKS_PER_SEC;
+
+  start = clock();
+  long long int sum_mask = 0;
+  for (int r = 0; r < n_rep; r++) {
+    for (unsigned int i = 0; i < n_sds; i++) {
+      for (int a = j_min_sd[i]; a <= ns; a++) {
+        int phase;
+        sd_bits mask_f;
+        unsigned int pf = sd_mask_annihilate(ns, n_p, &mask_sd[i], n_words, a, &phase, &mask_f);
+        if (pf != 0) {sum_mask += phase*(long long int) pf;}
+      }
+    }
+  }
+  double t_mask = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  // The sums keep the timed loops from being optimized away, the pairs were checked above
+  if (sum_walk != sum_mask) {printf("Error: mask annihilation disagrees with a_op\n"); exit(0);}
+
+  long long int n_ops = 0;
+  for (unsigned int i = 0; i < n_sds; i++) {n_ops += ns - j_min_sd[i] + 1;}
+  n_ops *= n_rep;
+  printf("Annihilation benchmark: %u %s SDs, %lld operators, %d-word masks\n", n_sds, label, n_ops, n_words);
+  printf("  a_op:        %g ns/op\n", 1e9*t_walk/n_ops);
+  printf("  masks:       %g ns/op\n", 1e9*t_mask/n_ops);
+  free(p_sd);
+  free(mask_sd);
+  free(j_min_sd);
+
+  return;
+}
+
+void benchmark_one_body_hops(wfnData* wd) {
+/* Build time, memory and trace time of the same-species one-body jumps, stored
+   as a jump to an intermediate SD with the dense reverse array a1_map_f (two
+   hops) or as direct a+a lists (one hop), over every shell pair conserving jz
+   Resolved tables are switched off so both sweeps walk their lists
+*/
+  int ns = wd->n_shells;
+  if (!wd->same_basis || (sd_mask_words(ns) == 0)) {
+    printf("One-body hop benchmark: needs a single basis and orbitals that fit in a mask\n");
+    return;
+  }
+  float mj_min_p_i = min_mj(ns, wd->n_proton_i, wd->jz_shell);
+  float mj_max_p_i = max_mj(ns, wd->n_proton_i, wd->jz_shell);
+  float mj_min_n_i = min_mj(ns, wd->n_neutron_i, wd->jz_shell);
+  float mj_max_n_i = max_mj(ns, wd->n_neutron_i, wd->jz_shell);
+  float half = (fabs(((int) (2*wd->j_nuc_i[0])) % 2) > pow(10, -3)) ? 0.5 : 0.0;
+  mj_min_p_i = MAX(mj_min_p_i, -mj_max_n_i + half);
+  mj_max_p_i = MIN(mj_max_p_i, -mj_min_n_i + half);
+  mj_min_n_i = MAX(mj_min_n_i, -mj_max_p_i + half);
+  mj_max_n_i = MIN(mj_max_n_i, -mj_min_p_i + half);
+  int num_mj_p_i = mj_max_p_i - mj_min_p_i + 1;
+  int num_mj_n_i = mj_max_n_i - mj_min_n_i + 1;
+  int w_cut = 51;
+
+  jump_table *p0_jumps_i = jump_table_create(2*num_mj_p_i, 0, 0);
+  jump_table *n0_jumps_i = jump_table_create(2*num_mj_n_i, 0, 0);
+  jump_table *p1_jumps_i = jump_table_create(2*ns*num_mj_p_i, 1, 0);
+  jump_table *n1_jumps_i = jump_table_create(2*ns*num_mj_n_i, 1, 0);
+  rev_map* p1_map_f = rev_map_create(ns, wd->n_proton_i - 1, 1, REV_MAP_MODE);
+  rev_map* n1_map_f = rev_map_create(ns, wd->n_neutron_i - 1, 1, REV_MAP_MODE);
+  clock_t start = clock();
+  build_one_body_jumps_i_and_f_trunc(ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p1_map_f, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_p_i);
+  build_one_body_jumps_i_and_f_trunc(ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n1_map_f, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_n_i);
+  double t_build_two = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  double mem_two = jump_table_memory(p1_jumps_i) + jump_table_memory(n1_jumps_i);
+  mem_two += rev_map_memory(p1_map_f) + rev_map_memory(n1_map_f);
+
+  jump_table *p11_jumps_i = jump_table_create(checked_count(2*ns, ns, num_mj_p_i), 1, 0);
+  jump_table *n11_jumps_i = jump_table_create(checked_count(2*ns, ns, num_mj_n_i), 1, 0);
+  start = clock();
+  build_one_body_hops_trunc(ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p11_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_p_i);
+  build_one_body_hops_trunc(ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n11_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_n_i);
+  double t_build_one = ((double) (clock() - start))/CLOCKS_PER_SEC;
+  double mem_one = jump_table_memory(p11_jumps_i) + jump_table_memory(n11_jumps_i);
+
+  resolved_cache *jumps = wd->jumps;
+  wd->jumps = NULL;
+  eigen_list *transition = create_eigen_node(0, 0, NULL);
+  double density[1];
+  double total_two = 0.0;
+  double total_one = 0.0;
+  double t_trace_two = 0.0;
+  double t_trace_one = 0.0;
+  for (int a = 0; a < ns; a++) {
+    for (int b = 0; b < ns; b++) {
+      if (wd->jz_shell[a] != wd->jz_shell[b]) {continue;}
+      start = clock();
+      density[0] = 0.0;
+      trace_1body_t0_nodes(a, b, num_mj_p_i, p1_map_f, p1_jumps_i, n0_jumps_i, wd, 0, transition, density);
+      trace_1body_t0_nodes(a, b, num_mj_n_i, n1_map_f, n1_jumps_i, p0_jumps_i, wd, 1, transition, density);
+      total_two += fabs(density[0]);
+      t_trace_two += ((double) (clock() - start))/CLOCKS_PER_SEC;
+      start = clock();
+      density[0] = 0.0;
+      trace_1body_t0_hops(a, b, num_mj_p_i, p11_jumps_i, n0_jumps_i, wd, 0, transition, density);
+      trace_1body_t0_hops(a, b, num_mj_n_i, n11_jumps_i, p0_jumps_i, wd, 1, transition, density);
+      total_one += fabs(density[0]);
+      t_trace_one += ((double) (clock() - start))/CLOCKS_PER_SEC;
+    }
+  }
+  wd->jumps = jumps;
+  if (fabs(total_one - total_two) > pow(10, -6)*fabs(total_two)) {printf("Error: one-hop trace disagrees with the two-hop trace\n"); exit(0);}
+
+  printf("One-body hop benchmark: %d shells, %u proton and %u neutron SDs\n", ns, wd->n_sds_p_i, wd->n_sds_n_i);
+  printf("  two hops: build %g sec, trace %g sec, %g MB\n", t_build_two, t_trace_two, mem_two/(1024*1024));
+  printf("  one hop:  build %g sec, trace %g sec, %g MB\n", t_build_one, t_trace_one, mem_one/(1024*1024));
+
+  jump_table_free(p0_jumps_i);
+  jump_table_free(n0_jumps_i);
+  jump_table_free(p1_jumps_i);
+  jump_table_free(n1_jumps_i);
+  jump_table_free(p11_jumps_i);
+  jump_table_free(n11_jumps_i);
+  rev_map_free(p1_map_f);
+  rev_map_free(n1_map_f);
+  free(transition);
+
+  return;
+}
+
+int bench_counter_open(uint32_t type, uint64_t config) {
+/* Opens a disabled hardware counter for this process, or returns -1 if the
+   counter is not available (no PMU, permissions, other platforms)
+*/
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = type;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+long long int bench_counter_read(int fd) {
+  long long int count = -1;
+#ifdef __linux__
+  if ((fd < 0) || (read(fd, &count, sizeof(count)) != sizeof(count))) {count = -1;}
+#endif
+  return count;
+}
+
+void benchmark_two_body_trace(wfnData* wd) {
+/* Times a sweep of the two-body trace kernels (a4, a22 and a20 over every shell
+   quadruple conserving jz) and counts L1D and LLC read misses where the hardware
+   counters are available. The sweep is repeated after renumbering the basis
+   states, unless the basis was already renumbered at load time, and the a4 and
+   a22 kernels are then timed against their composed variants
+*/
+  int ns = wd->n_shells;
+  float mj_min_p_i = min_mj(ns, wd->n_proton_i, wd->jz_shell);
+  float mj_max_p_i = max_mj(ns, wd->n_proton_i, wd->jz_shell);
+  float mj_min_n_i = min_mj(ns, wd->n_neutron_i, wd->jz_shell);
+  float mj_max_n_i = max_mj(ns, wd->n_neutron_i, wd->jz_shell);
+  float half = (fabs(((int) (2*wd->j_nuc_i[0])) % 2) > pow(10, -3)) ? 0.5 : 0.0;
+  mj_min_p_i = MAX(mj_min_p_i, -mj_max_n_i + half);
+  mj_max_p_i = MIN(mj_max_p_i, -mj_min_n_i + half);
+  mj_min_n_i = MAX(mj_min_n_i, -mj_max_p_i + half);
+  mj_max_n_i = MIN(mj_max_n_i, -mj_min_p_i + half);
+  int num_mj_i = mj_max_p_i - mj_min_p_i + 1;
+
+  jump_table *p0_jumps_i = jump_table_create(2*num_mj_i, 0, 0);
+  jump_table *n0_jumps_i = jump_table_create(2*num_mj_i, 0, 0);
+  jump_table *p1_jumps_i = jump_table_create(2*ns*num_mj_i, 1, 0);
+  jump_table *n1_jumps_i = jump_table_create(2*ns*num_mj_i, 1, 0);
+  jump_table *p2_jumps_i = jump_table_create(2*ns*ns*num_mj_i, 1, 0);
+  jump_table *n2_jumps_i = jump_table_create(2*ns*ns*num_mj_i, 1, 0);
+  jump_table *p2_jumps_f = jump_table_create(2*ns*ns*num_mj_i, 1, 0);
+  jump_table *n2_jumps_f = jump_table_create(2*ns*ns*num_mj_i, 1, 0);
+  rev_map* p1_map_f = rev_map_create(ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+  rev_map* p2_map_f = rev_map_create(ns, wd->n_proton_f - 2, 2, REV_MAP_MODE);
+  rev_map* n1_map_f = rev_map_create(ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
+  rev_map* n2_map_f = rev_map_create(ns, wd->n_neutron_f - 2, 2, REV_MAP_MODE);
+  if (wd->same_basis) {
+    build_two_body_jumps_i_and_f(ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p1_map_f, p2_map_f, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+    build_two_body_jumps_i_and_f(ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n1_map_f, n2_map_f, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+  } else {
+    build_two_body_jumps_i(ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+    build_two_body_jumps_f(ns, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, p1_map_f, p2_map_f, p2_jumps_f, wd->jz_shell, wd->l_shell, wd->present_p_f);
+    build_two_body_jumps_i(ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+    build_two_body_jumps_f(ns, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n1_map_f, n2_map_f, n2_jumps_f, wd->jz_shell, wd->l_shell, wd->present_n_f);
+  }
+  const char *rev_mode[3] = {"dense", "runs", "on demand"};
+  printf("Reverse maps: protons %s %g MB + %s %g MB, neutrons %s %g MB + %s %g MB\n", rev_mode[p1_map_f->mode], rev_map_memory(p1_map_f)/(1024*1024), rev_mode[p2_map_f->mode], rev_map_memory(p2_map_f)/(1024*1024), rev_mode[n1_map_f->mode], rev_map_memory(n1_map_f)/(1024*1024), rev_mode[n2_map_f->mode], rev_map_memory(n2_map_f)/(1024*1024));
+  // Resolved tables would skip the walks being measured and go stale on renumbering
+  resolved_cache_free(wd->jumps);
+  wd->jumps = NULL;
+
+  eigen_list *transition = create_eigen_node(0, 0, NULL);
+  double density[1];
+  int fd_l1 = bench_counter_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  int fd_llc = bench_counter_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  if ((fd_l1 < 0) || (fd_llc < 0)) {printf("Hardware cache counters are not available, reporting times only\n");}
+  printf("Two-body trace benchmark: %lld initial states, %d shells\n", wd->n_states_i, ns);
+  double total_ref = 0.0;
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      if (wd->renumbered) {break;}
+      renumber_basis_states(wd);
+      if (!wd->renumbered) {break;}
+    }
+    if (fd_l1 >= 0) {ioctl(fd_l1, PERF_EVENT_IOC_RESET, 0); ioctl(fd_l1, PERF_EVENT_IOC_ENABLE, 0);}
+    if (fd_llc >= 0) {ioctl(fd_llc, PERF_EVENT_IOC_RESET, 0); ioctl(fd_llc, PERF_EVENT_IOC_ENABLE, 0);}
+    clock_t start = clock();
+    double total = 0.0;
+    for (int a = 0; a < ns; a++) {
+      for (int b = 0; b < ns; b++) {
+        if (b == a) {continue;}
+        for (int c = 0; c < ns; c++) {
+          for (int d = 0; d < ns; d++) {
+            if (d == c) {continue;}
+            if (wd->jz_shell[a] + wd->jz_shell[b] != wd->jz_shell[c] + wd->jz_shell[d]) {continue;}
+            density[0] = 0.0;
+            trace_a4_nodes(a, b, c, d, num_mj_i, p2_map_f, p2_jumps_i, n0_jumps_i, wd, 0, transition, density);
+            trace_a4_nodes(a, b, c, d, num_mj_i, n2_map_f, n2_jumps_i, p0_jumps_i, wd, 1, transition, density);
+            trace_a22_nodes(a, b, c, d, num_mj_i, p2_jumps_i, n2_jumps_f, wd, 0, transition, density);
+            trace_a22_nodes(a, b, c, d, num_mj_i, n2_jumps_i, p2_jumps_f, wd, 1, transition, density);
+            trace_a20_nodes(a, c, b, d, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, transition, density);
+            total += fabs(density[0]);
+          }
+        }
+      }
+    }
+    double t_sweep = ((double) (clock() - start))/CLOCKS_PER_SEC;
+    if (fd_l1 >= 0) {ioctl(fd_l1, PERF_EVENT_IOC_DISABLE, 0);}
+    if (fd_llc >= 0) {ioctl(fd_llc, PERF_EVENT_IOC_DISABLE, 0);}
+    long long int miss_l1 = bench_counter_read(fd_l1);
+    long long int miss_llc = bench_counter_read(fd_llc);
+    if (pass == 0) {total_ref = total;}
+    if (fabs(total - total_ref) > pow(10, -6)*fabs(total_ref)) {printf("Error: renumbered sweep disagrees with the original order\n"); exit(0);}
+    printf("  %s: %g sec", (wd->renumbered) ? "renumbered basis" : "BIGSTICK order ", t_sweep);
+    if (miss_l1 >= 0) {printf(", %lld L1D read misses", miss_l1);}
+    if (miss_llc >= 0) {printf(", %lld LLC read misses", miss_llc);}
+    printf("\n");
+  }
+
+  // Same-species and charge-changing kernels from the two-body lists, and composed from the one-body lists
+  double mem_lists = jump_table_memory(p2_jumps_i) + jump_table_memory(n2_jumps_i);
+  mem_lists += jump_table_memory(p2_jumps_f) + jump_table_memory(n2_jumps_f);
+  double mem_compose = jump_table_memory(p1_jumps_i) + jump_table_memory(n1_jumps_i);
+  double total_lists = 0.0;
+  double total_compose = 0.0;
+  double t_lists = 0.0;
+  double t_compose = 0.0;
+  pair_jumps pairs[2] = {{-1, -1, -1, NULL}, {-1, -1, -1, NULL}};
+  for (int a = 0; a < ns; a++) {
+    for (int b = 0; b < ns; b++) {
+      if (b == a) {continue;}
+      for (int c = 0; c < ns; c++) {
+        for (int d = 0; d < ns; d++) {
+          if (d == c) {continue;}
+          if (wd->jz_shell[a] + wd->jz_shell[b] != wd->jz_shell[c] + wd->jz_shell[d]) {continue;}
+          clock_t start = clock();
+          density[0] = 0.0;
+          trace_a4_nodes(a, b, c, d, num_mj_i, p2_map_f, p2_jumps_i, n0_jumps_i, wd, 0, transition, density);
+          trace_a4_nodes(a, b, c, d, num_mj_i, n2_map_f, n2_jumps_i, p0_jumps_i, wd, 1, transition, density);
+          trace_a22_nodes(a, b, c, d, num_mj_i, p2_jumps_i, n2_jumps_f, wd, 0, transition, density);
+          trace_a22_nodes(a, b, c, d, num_mj_i, n2_jumps_i, p2_jumps_f, wd, 1, transition, density);
+          total_lists += fabs(density[0]);
+          t_lists += ((double) (clock() - start))/CLOCKS_PER_SEC;
+          start = clock();
+          density[0] = 0.0;
+          trace_a4_nodes_compose(a, b, c, d, num_mj_i, p2_map_f, p1_jumps_i, n0_jumps_i, wd, 0, transition, density);
+          trace_a4_nodes_compose(a, b, c, d, num_mj_i, n2_map_f, n1_jumps_i, p0_jumps_i, wd, 1, transition, density);
+          trace_a22_nodes_compose(a, b, c, d, num_mj_i, p1_jumps_i, pair_jumps_get(&pairs[0], a, b, num_mj_i, n2_map_f, n0_jumps_i, wd, 0, 0), wd, 0, transition, density);
+          trace_a22_nodes_compose(a, b, c, d, num_mj_i, n1_jumps_i, pair_jumps_get(&pairs[1], a, b, num_mj_i, p2_map_f, p0_jumps_i, wd, 1, 0), wd, 1, transition, density);
+          total_compose += fabs(density[0]);
+          t_compose += ((double) (clock() - start))/CLOCKS_PER_SEC;
+        }
+      }
+    }
+  }
+  if (fabs(total_compose - total_lists) > pow(10, -6)*fabs(total_lists)) {printf("Error: composed two-body jumps disagree with the two-body lists\n"); exit(0);}
+  printf("  a4/a22 from two-body lists: %g MB, %g sec\n", mem_lists/(1024*1024), t_lists);
+  printf("  a4/a22 composed from one-body lists: %g MB, %g sec\n", mem_compose/(1024*1024), t_compose);
+  if (fd_l1 >= 0) {close(fd_l1);}
+  if (fd_llc >= 0) {close(fd_llc);}
+  pair_jumps_free(&pairs[0]);
+  pair_jumps_free(&pairs[1]);
+  jump_table_free(p0_jumps_i);
+  jump_table_free(n0_jumps_i);
+  jump_table_free(p1_jumps_i);
+  jump_table_free(n1_jumps_i);
+  jump_table_free(p2_jumps_i);
+  jump_table_free(n2_jumps_i);
+  jump_table_free(p2_jumps_f);
+  jump_table_free(n2_jumps_f);
+  rev_map_free(p1_map_f);
+  rev_map_free(p2_map_f);
+  rev_map_free(n1_map_f);
+  rev_map_free(n2_map_f);
+  free(transition);
+
+  return;
+}
+
+void benchmark_jump_compress(wfnData* wd) {
+/* Memory and trace time of the two-body jump tables stored as packed arrays and
+   as delta/varint streams (JUMP_COMPRESS), over the a4 and a22 sweep of
+   benchmark_two_body_trace
+*/
+  int ns = wd->n_shells;
+  float mj_min_p_i = min_mj(ns, wd->n_proton_i, wd->jz_shell);
+  float mj_max_p_i = max_mj(ns, wd->n_proton_i, wd->jz_shell);
+  float mj_min_n_i = min_mj(ns, wd->n_neutron_i, wd->jz_shell);
+  float mj_max_n_i = max_mj(ns, wd->n_neutron_i, wd->jz_shell);
+  float half = (fabs(((int) (2*wd->j_nuc_i[0])) % 2) > pow(10, -3)) ? 0.5 : 0.0;
+  mj_min_p_i = MAX(mj_min_p_i, -mj_max_n_i + half);
+  mj_max_p_i = MIN(mj_max_p_i, -mj_min_n_i + half);
+  mj_min_n_i = MAX(mj_min_n_i, -mj_max_p_i + half);
+  mj_max_n_i = MIN(mj_max_n_i, -mj_min_p_i + half);
+  int num_mj_i = mj_max_p_i - mj_min_p_i + 1;
+
+  resolved_cache_free(wd->jumps);
+  wd->jumps = NULL;
+  eigen_list *transition = create_eigen_node(0, 0, NULL);
+  double density[1];
+  double total_ref = 0.0;
+  printf("Jump compression benchmark: %d shells, %u proton and %u neutron SDs\n", ns, wd->n_sds_p_i, wd->n_sds_n_i);
+  for (int compressed = 0; compressed <= 1; compressed++) {
+    jump_table *jumps[8];
+    jumps[0] = jump_table_create(2*num_mj_i, 0, 0); // p0_i
+    jumps[1] = jump_table_create(2*num_mj_i, 0, 0); // n0_i
+    jumps[2] = jump_table_create(2*ns*num_mj_i, 1, 0); // p1_i
+    jumps[3] = jump_table_create(2*ns*num_mj_i, 1, 0); // n1_i
+    jumps[4] = jump_table_create(2*ns*ns*num_mj_i, 1, 0); // p2_i
+    jumps[5] = jump_table_create(2*ns*ns*num_mj_i, 1, 0); // n2_i
+    jumps[6] = jump_table_create(2*ns*ns*num_mj_i, 1, 0); // p2_f
+    jumps[7] = jump_table_create(2*ns*ns*num_mj_i, 1, 0); // n2_f
+    for (int i = 0; i < 8; i++) {jump_table_set_compressed(jumps[i], compressed);}
+    rev_map* p1_map_f = rev_map_create(ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+    rev_map* p2_map_f = rev_map_create(ns, wd->n_proton_f - 2, 2, REV_MAP_MODE);
+    rev_map* n1_map_f = rev_map_create(ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
+    rev_map* n2_map_f = rev_map_create(ns, wd->n_neutron_f - 2, 2, REV_MAP_MODE);
+    clock_t start = clock();
+    if (wd->same_basis) {
+      build_two_body_jumps_i_and_f(ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p1_map_f, p2_map_f, jumps[0], jumps[2], jumps[4], wd->jz_shell, wd->l_shell, wd->present_p_i);
+      build_two_body_jumps_i_and_f(ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n1_map_f, n2_map_f, jumps[1], jumps[3], jumps[5], wd->jz_shell, wd->l_shell, wd->present_n_i);
+    } else {
+      build_two_body_jumps_i(ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, jumps[0], jumps[2], jumps[4], wd->jz_shell, wd->l_shell, wd->present_p_i);
+      build_two_body_jumps_f(ns, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, p1_map_f, p2_map_f, jumps[6], wd->jz_shell, wd->l_shell, wd->present_p_f);
+      build_two_body_jumps_i(ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, jumps[1], jumps[3], jumps[5], wd->jz_shell, wd->l_shell, wd->present_n_i);
+      build_two_body_jumps_f(ns, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n1_map_f, n2_map_f, jumps[7], wd->jz_shell, wd->l_shell, wd->present_n_f);
+    }
+    double t_build = ((double) (clock() - start))/CLOCKS_PER_SEC;
+    double mem = 0.0;
+    double mem_rows = 0.0;
+    size_t n_entries = 0;
+    for (int i = 0; i < 8; i++) {
+      mem += jump_table_memory(jumps[i]);
+      mem_rows += (1 + compressed)*sizeof(size_t)*(double) (jumps[i]->n_rows + 1);
+      n_entries += jumps[i]->start[jumps[i]->n_rows];
+    }
+
+    start = clock();
+    double total = 0.0;
+    for (int a = 0; a < ns; a++) {
+      for (int b = 0; b < ns; b++) {
+        if (b == a) {continue;}
+        for (int c = 0; c < ns; c++) {
+          for (int d = 0; d < ns; d++) {
+            if (d == c) {continue;}
+            if (wd->jz_shell[a] + wd->jz_shell[b] != wd->jz_shell[c] + wd->jz_shell[d]) {continue;}
+            density[0] = 0.0;
+            trace_a4_nodes(a, b, c, d, num_mj_i, p2_map_f, jumps[4], jumps[1], wd, 0, transition, density);
+            trace_a4_nodes(a, b, c, d, num_mj_i, n2_map_f, jumps[5], jumps[0], wd, 1, transition, density);
+            trace_a22_nodes(a, b, c, d, num_mj_i, jumps[4], jumps[7], wd, 0, transition, density);
+            trace_a22_nodes(a, b, c, d, num_mj_i, jumps[5], jumps[6], wd, 1, transition, density);
+            total += fabs(density[0]);
+          }
+        }
+      }
+    }
+    double t_trace = ((double) (clock() - start))/CLOCKS_PER_SEC;
+    if (compressed == 0) {total_ref = total;}
+    if (fabs(total - total_ref) > pow(10, -6)*fabs(total_ref)) {printf("Error: compressed jump tables disagree with the packed tables\n"); exit(0);}
+    printf("  %s: %zu jumps, %g MB of entries (%g bytes per jump) + %g MB of row offsets, build %g sec, a4/a22 sweep %g sec\n", (compressed) ? "delta/varint" : "packed      ", n_entries, (mem - mem_rows)/(1024*1024), (mem - mem_rows)/MAX(n_entries, 1), mem_rows/(1024*1024), t_build, t_trace);
+
+    for (int i = 0; i < 8; i++) {jump_table_free(jumps[i]);}
+    rev_map_free(p1_map_f);
+    rev_map_free(p2_map_f);
+    rev_map_free(n1_map_f);
+    rev_map_free(n2_map_f);
+  }
+  free(transition);
+
+  return;
+}
@@ -0,0 +1,31 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include "density.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+void run_benchmarks(speedParams* sp);
+
+void benchmark_basis_lookup(wfnData* wd, char* basis_file);
+
+void benchmark_binomial(wfnData* wd);
+
+void benchmark_sd_decode(wfnData* wd, int n_p, char* label);
+
+void benchmark_annihilation(wfnData* wd, int n_p, char* label);
+
+void benchmark_one_body_hops(wfnData* wd);
+
+void benchmark_two_body_trace(wfnData* wd);
+
+void benchmark_jump_compress(wfnData* wd);
+
+int bench_counter_open(uint32_t type, uint64_t config);
+
+long long int bench_counter_read(int fd);
+
+#endif
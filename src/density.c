@@ -56,47 +56,86 @@ void two_body_density_spec(speedParams *sp) {
 
   int n_spec_bins = max_n_spec_q - min_n_spec_q + 1;
   printf("Min spec excitations: %d Max spec excitations: %d\n", min_n_spec_q, max_n_spec_q);
-  // Allocate space for jump lists
-  wfe_list **p0_list_i = (wfe_list**) calloc(2*num_mj_i, sizeof(wfe_list*));
-  wfe_list **n0_list_i = (wfe_list**) calloc(2*num_mj_i, sizeof(wfe_list*));
-  sde_list **p1_list_i = (sde_list**) calloc(2*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **n1_list_i = (sde_list**) calloc(2*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **p2_list_i = (sde_list**) calloc(2*ns*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **n2_list_i = (sde_list**) calloc(2*ns*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **p2_list_f = (sde_list**) calloc(2*ns*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **n2_list_f = (sde_list**) calloc(2*ns*ns*num_mj_i, sizeof(sde_list*));
-  int* p1_array_f = (int*) calloc(ns*n_sds_p_int1, sizeof(int));
-  int* p2_array_f = (int*) calloc(ns*ns*n_sds_p_int2, sizeof(int));
-  int* n1_array_f = (int*) calloc(ns*n_sds_n_int1, sizeof(int));
-  int* n2_array_f = (int*) calloc(ns*ns*n_sds_n_int2, sizeof(int));
+  // Jumps are built once and shared by both species when their builders see the same SDs
+  jump_key p_key_i = {ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, -1, wd->n_sds_p_i, wd->present_p_i};
+  jump_key n_key_i = {ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, -1, wd->n_sds_n_i, wd->present_n_i};
+  jump_key p_key_f = {ns, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, -1, wd->n_sds_p_f, wd->present_p_f};
+  jump_key n_key_f = {ns, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, -1, wd->n_sds_n_f, wd->present_n_f};
+  int share_i = jump_keys_match(&p_key_i, &n_key_i);
+  int share_f = (wd->same_basis) ? share_i : jump_keys_match(&p_key_f, &n_key_f);
+  // Only the tables and maps of the trace kernels the operator reaches are built
+  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
+  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
+  float mt_op = mtf - mti;
+  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
+  // Two-body lists hold about ns times the entries of the one-body lists, the traces can compose them instead
+  int compose = TWO_BODY_COMPOSE;
+  // Created-species jumps of the composed a22 trace, shared by every (c, d) of a pair (a, b)
+  pair_jumps pairs = {-1, -1, -1, NULL};
+  jump_plan plan = plan_two_body_jumps(mt_op, compose, share_i, share_f);
+  log_jump_plan(&plan, wd, num_mj_i, 1);
+  // Allocate space for jump lists, released together with their arena once the densities are written
+  arena *jump_arena = arena_create((size_t) ARENA_BLOCK_MB*1024*1024);
+  jump_table *p0_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(0), 2*num_mj_i, 0, 1);
+  jump_table *n0_jumps_i = share_i ? p0_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(0), 2*num_mj_i, 0, 1);
+  jump_table *p1_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(1), 2*ns*num_mj_i, 1, 1);
+  jump_table *n1_jumps_i = share_i ? p1_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(1), 2*ns*num_mj_i, 1, 1);
+  jump_table *p2_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 1);
+  jump_table *n2_jumps_i = share_i ? p2_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 1);
+  jump_table *p2_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[0] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 1);
+  jump_table *n2_jumps_f = share_f ? p2_jumps_f : jump_table_planned(jump_arena, plan.jumps_f[1] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 1);
+  rev_map* p1_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(1), ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+  rev_map* p2_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(2), ns, wd->n_proton_f - 2, 2, REV_MAP_MODE);
+  rev_map* n1_map_f = share_f ? p1_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(1), ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
+  rev_map* n2_map_f = share_f ? p2_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(2), ns, wd->n_neutron_f - 2, 2, REV_MAP_MODE);
 
   // Determine one/two-body jumps, using special routine if initial and final bases are the same
   if (wd->same_basis) {
-    printf("Building proton jumps...\n");
-    build_two_body_jumps_i_and_f_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, n_sds_p_int1, n_sds_p_int2, p1_array_f, p2_array_f, p0_list_i, p1_list_i, p2_list_i, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done.\n");
-    printf("Building neutron jumps...\n");
-    build_two_body_jumps_i_and_f_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n_sds_n_int1, n_sds_n_int2, n1_array_f, n2_array_f, n0_list_i, n1_list_i, n2_list_i, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done.\n");
+    if (plan.jumps_i[0] || plan.maps_f[0]) {
+      printf("Building proton jumps...\n");
+      build_two_body_jumps_i_and_f_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p1_map_f, p2_map_f, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_p_i);
+      printf("Done.\n");
+    }
+    if (share_i) {
+      printf("Neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1] || plan.maps_f[1]) {
+        printf("Building neutron jumps...\n");
+        build_two_body_jumps_i_and_f_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n1_map_f, n2_map_f, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_n_i);
+        printf("Done.\n");
+      }
+    }
   } else {
-    printf("Building initial state proton jumps...\n");
-    build_two_body_jumps_i_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_list_i, p1_list_i, p2_list_i, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done\n");
-    printf("Building final state proton jumps...\n");
-    build_two_body_jumps_f_spec(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, n_sds_p_int1, n_sds_p_int2, p1_array_f, p2_array_f, p2_list_f, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done\n");
-    printf("Building initial state neutron jumps...\n");
-    build_two_body_jumps_i_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_list_i, n1_list_i, n2_list_i, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Building final state neutron jumps...\n");
-    build_two_body_jumps_f_spec(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n_sds_n_int1, n_sds_n_int2, n1_array_f, n2_array_f, n2_list_f, wd->jz_shell, wd->l_shell, wd->n_shell);
+    if (plan.jumps_i[0]) {
+      printf("Building initial state proton jumps...\n");
+      build_two_body_jumps_i_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_p_i);
+      printf("Done\n");
+    }
+    if (plan.jumps_f[0] || plan.maps_f[0]) {
+      printf("Building final state proton jumps...\n");
+      build_two_body_jumps_f_spec(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, p1_map_f, p2_map_f, p2_jumps_f, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_p_f);
+      printf("Done\n");
+    }
+    if (share_i) {
+      printf("Initial state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1]) {
+        printf("Building initial state neutron jumps...\n");
+        build_two_body_jumps_i_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_n_i);
+      }
+    }
+    if (share_f) {
+      printf("Final state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_f[1] || plan.maps_f[1]) {
+        printf("Building final state neutron jumps...\n");
+        build_two_body_jumps_f_spec(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n1_map_f, n2_map_f, n2_jumps_f, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_n_f);
+      }
+    }
     printf("Done.\n");
   }
 
   double* cg_fact = (double*) calloc(sp->n_trans, sizeof(double));
-  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
-  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
-  float mt_op = mtf - mti;
-  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
   FILE *out_file;
   char output_density_file[100];
   char output_log_file[100];
@@ -217,27 +256,43 @@ void two_body_density_spec(speedParams *sp) {
                   }
                   if ((mt3 == 0.5) && (mt4 == 0.5)) { // 
                     if ((mt1 == 0.5) && (mt2 == 0.5)) { // 2 proton creation operators + 2 proton annihilation operators
-                      trace_a4_nodes_spec(a, b, c, d, num_mj_i, n_sds_p_int2, p2_array_f, p2_list_i, n0_list_i, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      if (compose) {
+                        trace_a4_nodes_spec_compose(a, b, c, d, num_mj_i, p2_map_f, p1_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      } else {
+                        trace_a4_nodes_spec(a, b, c, d, num_mj_i, p2_map_f, p2_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      }
                     } else if ((mt1 == -0.5) && (mt2 == -0.5)) { // 2 neutron creation operators and two proton ann. operators
-                      trace_a22_nodes_spec(a, b, c, d, num_mj_i, p2_list_i, n2_list_f, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      if (compose) {
+                        trace_a22_nodes_spec_compose(a, b, c, d, num_mj_i, p1_jumps_i, pair_jumps_get(&pairs, a, b, num_mj_i, n2_map_f, n0_jumps_i, wd, 0, 1), wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      } else {
+                        trace_a22_nodes_spec(a, b, c, d, num_mj_i, p2_jumps_i, n2_jumps_f, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      }
                     }  
                   } else if ((mt3 == -0.5) && (mt4 == -0.5)) {
                     if ((mt1 == -0.5) && (mt2 == -0.5)) { //2 n cr. and 2 n ann. operators
-                      trace_a4_nodes_spec(a, b, c, d, num_mj_i, n_sds_n_int2, n2_array_f, n2_list_i, p0_list_i, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      if (compose) {
+                        trace_a4_nodes_spec_compose(a, b, c, d, num_mj_i, n2_map_f, n1_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      } else {
+                        trace_a4_nodes_spec(a, b, c, d, num_mj_i, n2_map_f, n2_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      }
                     } else if ((mt1 == 0.5) && (mt2 == 0.5)) {// 2 p cr. and 2 n ann. operators
-                      trace_a22_nodes_spec(a, b, c, d, num_mj_i, n2_list_i, p2_list_f, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      if (compose) {
+                        trace_a22_nodes_spec_compose(a, b, c, d, num_mj_i, n1_jumps_i, pair_jumps_get(&pairs, a, b, num_mj_i, p2_map_f, p0_jumps_i, wd, 1, 1), wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      } else {
+                        trace_a22_nodes_spec(a, b, c, d, num_mj_i, n2_jumps_i, p2_jumps_f, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      }
                     }
                   } else if ((mt1 == 0.5) && (mt2 == -0.5) && (mt3 == 0.5) && (mt4 == -0.5)) {
-                      trace_a20_nodes_spec(a, d, b, c, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      trace_a20_nodes_spec(a, d, b, c, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
                       for (int i = 0; i < n_spec_bins*sp->n_trans; i++) {
                         density[i] = -density[i];
                       }
                   } else if ((mt1 == -0.5) && (mt2 == 0.5) && (mt3 == 0.5) && (mt4 == -0.5)) {
-                      trace_a20_nodes_spec(b, d, a, c, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      trace_a20_nodes_spec(b, d, a, c, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
                   } else if ((mt1 == 0.5) && (mt2 == -0.5) && (mt3 == -0.5) && (mt4 == 0.5)) {
-                      trace_a20_nodes_spec(a, c, b, d, num_mj_i, n_sds_p_int1, n_sds_n_int1,p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      trace_a20_nodes_spec(a, c, b, d, num_mj_i,p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
                   } else if ((mt1 == -0.5) && (mt2 == 0.5) && (mt3 == -0.5) && (mt4 == 0.5)) {
-                      trace_a20_nodes_spec(b, c, a, d, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+                      trace_a20_nodes_spec(b, c, a, d, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density, min_n_spec_q, n_spec_bins);
                       for (int i = 0; i < n_spec_bins*sp->n_trans; i++) {
                         density[i] = -density[i];
                       }
@@ -335,6 +390,19 @@ void two_body_density_spec(speedParams *sp) {
   }
   free(j_store); 
   
+  report_lookup_stats(wd);
+  free(cg_fact);
+  free(density);
+  pair_jumps_free(&pairs);
+  arena_free(jump_arena);
+  rev_map_free(p1_map_f);
+  rev_map_free(p2_map_f);
+  if (!share_f) {
+    rev_map_free(n1_map_f);
+    rev_map_free(n2_map_f);
+  }
+  wfn_data_free(wd);
+
   return;
 }
 
@@ -394,48 +462,87 @@ void two_body_density_trunc(speedParams *sp) {
   printf("Number of m_j sectors:%d\n", num_mj_i);
   printf("%g, %g, %g, %g\n", mj_min_p_i, mj_max_p_i, mj_min_n_i, mj_max_n_i);
 
-  // Allocate space for jump lists
-  wf_list **p0_list_i = (wf_list**) calloc(2*num_mj_i, sizeof(wf_list*));
-  wf_list **n0_list_i = (wf_list**) calloc(2*num_mj_i, sizeof(wf_list*));
-  sd_list **p1_list_i = (sd_list**) calloc(2*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **n1_list_i = (sd_list**) calloc(2*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **p2_list_i = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **n2_list_i = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **p2_list_f = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **n2_list_f = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  int* p1_array_f = (int*) calloc(ns*n_sds_p_int1, sizeof(int));
-  int* p2_array_f = (int*) calloc(ns*ns*n_sds_p_int2, sizeof(int));
-  int* n1_array_f = (int*) calloc(ns*n_sds_n_int1, sizeof(int));
-  int* n2_array_f = (int*) calloc(ns*ns*n_sds_n_int2, sizeof(int));
+  // Jumps are built once and shared by both species when their builders see the same SDs
+  jump_key p_key_i = {ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->same_basis ? 8 : -1, wd->n_sds_p_i, wd->present_p_i};
+  jump_key n_key_i = {ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->same_basis ? 8 : -1, wd->n_sds_n_i, wd->present_n_i};
+  jump_key p_key_f = {ns, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, -1, wd->n_sds_p_f, wd->present_p_f};
+  jump_key n_key_f = {ns, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, -1, wd->n_sds_n_f, wd->present_n_f};
+  int share_i = jump_keys_match(&p_key_i, &n_key_i);
+  int share_f = (wd->same_basis) ? share_i : jump_keys_match(&p_key_f, &n_key_f);
+  // Only the tables and maps of the trace kernels the operator reaches are built
+  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
+  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
+  float mt_op = mtf - mti;
+  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
+  // Two-body lists hold about ns times the entries of the one-body lists, the traces can compose them instead
+  int compose = TWO_BODY_COMPOSE;
+  // Created-species jumps of the composed a22 trace, shared by every (c, d) of a pair (a, b)
+  pair_jumps pairs = {-1, -1, -1, NULL};
+  jump_plan plan = plan_two_body_jumps(mt_op, compose, share_i, share_f);
+  log_jump_plan(&plan, wd, num_mj_i, 0);
+  // Allocate space for jump lists, released together with their arena once the densities are written
+  arena *jump_arena = arena_create((size_t) ARENA_BLOCK_MB*1024*1024);
+  jump_table *p0_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(0), 2*num_mj_i, 0, 0);
+  jump_table *n0_jumps_i = share_i ? p0_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(0), 2*num_mj_i, 0, 0);
+  jump_table *p1_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(1), 2*ns*num_mj_i, 1, 0);
+  jump_table *n1_jumps_i = share_i ? p1_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(1), 2*ns*num_mj_i, 1, 0);
+  jump_table *p2_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  jump_table *n2_jumps_i = share_i ? p2_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  jump_table *p2_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[0] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  jump_table *n2_jumps_f = share_f ? p2_jumps_f : jump_table_planned(jump_arena, plan.jumps_f[1] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  rev_map* p1_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(1), ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+  rev_map* p2_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(2), ns, wd->n_proton_f - 2, 2, REV_MAP_MODE);
+  rev_map* n1_map_f = share_f ? p1_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(1), ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
+  rev_map* n2_map_f = share_f ? p2_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(2), ns, wd->n_neutron_f - 2, 2, REV_MAP_MODE);
 
 
   // Determine one/two-body jumps, using special routine if initial and final bases are the same
   if (wd->same_basis) {
-    printf("Building proton jumps...\n");
-    build_two_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, n_sds_p_int1, n_sds_p_int2, p1_array_f, p2_array_f, p0_list_i, p1_list_i, p2_list_i, wd->jz_shell, wd->l_shell, wd->w_shell, 8);
-    printf("Done.\n");
-    printf("Building neutron jumps...\n");
-    build_two_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n_sds_n_int1, n_sds_n_int2, n1_array_f, n2_array_f, n0_list_i, n1_list_i, n2_list_i, wd->jz_shell, wd->l_shell, wd->w_shell, 8);
-    printf("Done.\n");
+    if (plan.jumps_i[0] || plan.maps_f[0]) {
+      printf("Building proton jumps...\n");
+      build_two_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p1_map_f, p2_map_f, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, 8, wd->present_p_i);
+      printf("Done.\n");
+    }
+    if (share_i) {
+      printf("Neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1] || plan.maps_f[1]) {
+        printf("Building neutron jumps...\n");
+        build_two_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n1_map_f, n2_map_f, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, 8, wd->present_n_i);
+        printf("Done.\n");
+      }
+    }
   } else {
-    printf("Building initial state proton jumps...\n");
-    build_two_body_jumps_i(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_list_i, p1_list_i, p2_list_i, wd->jz_shell, wd->l_shell);
-    printf("Done\n");
-    printf("Building final state proton jumps...\n");
-    build_two_body_jumps_f(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, n_sds_p_int1, n_sds_p_int2, p1_array_f, p2_array_f, p2_list_f, wd->jz_shell, wd->l_shell);
-    printf("Done\n");
-    printf("Building initial state neutron jumps...\n");
-    build_two_body_jumps_i(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_list_i, n1_list_i, n2_list_i, wd->jz_shell, wd->l_shell);
-    printf("Building final state neutron jumps...\n");
-    build_two_body_jumps_f(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n_sds_n_int1, n_sds_n_int2, n1_array_f, n2_array_f, n2_list_f, wd->jz_shell, wd->l_shell);
+    if (plan.jumps_i[0]) {
+      printf("Building initial state proton jumps...\n");
+      build_two_body_jumps_i(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+      printf("Done\n");
+    }
+    if (plan.jumps_f[0] || plan.maps_f[0]) {
+      printf("Building final state proton jumps...\n");
+      build_two_body_jumps_f(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, p1_map_f, p2_map_f, p2_jumps_f, wd->jz_shell, wd->l_shell, wd->present_p_f);
+      printf("Done\n");
+    }
+    if (share_i) {
+      printf("Initial state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1]) {
+        printf("Building initial state neutron jumps...\n");
+        build_two_body_jumps_i(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+      }
+    }
+    if (share_f) {
+      printf("Final state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_f[1] || plan.maps_f[1]) {
+        printf("Building final state neutron jumps...\n");
+        build_two_body_jumps_f(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n1_map_f, n2_map_f, n2_jumps_f, wd->jz_shell, wd->l_shell, wd->present_n_f);
+      }
+    }
     printf("Done.\n");
   }
 
   double* cg_fact = (double*) calloc(sp->n_trans, sizeof(double));
-  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
-  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
-  float mt_op = mtf - mti;
-  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
   FILE *out_file;
   char output_density_file[100];
   char output_log_file[100];
@@ -560,27 +667,43 @@ void two_body_density_trunc(speedParams *sp) {
                   for (int i = 0; i < sp->n_trans; i++) {density[i] = 0.0;}
                   if ((mt3 == 0.5) && (mt4 == 0.5)) { // 
                     if ((mt1 == 0.5) && (mt2 == 0.5)) { // 2 proton creation operators + 2 proton annihilation operators
-                      trace_a4_nodes(a, b, c, d, num_mj_i, n_sds_p_int2, p2_array_f, p2_list_i, n0_list_i, wd, 0, sp->transition_list, density);
+                      if (compose) {
+                        trace_a4_nodes_compose(a, b, c, d, num_mj_i, p2_map_f, p1_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
+                      } else {
+                        trace_a4_nodes(a, b, c, d, num_mj_i, p2_map_f, p2_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
+                      }
                     } else if ((mt1 == -0.5) && (mt2 == -0.5)) { // 2 neutron creation operators and two proton ann. operators
                       if ((fabs(mj1 + mj2) > (mj_max_n_i - mj_min_n_i)) || (fabs(mj3 + mj4) > (mj_max_p_i - mj_min_p_i))) {printf("Saved time\n"); continue;}
-                      trace_a22_nodes(a, b, c, d, num_mj_i, p2_list_i, n2_list_f, wd, 0, sp->transition_list, density);
+                      if (compose) {
+                        trace_a22_nodes_compose(a, b, c, d, num_mj_i, p1_jumps_i, pair_jumps_get(&pairs, a, b, num_mj_i, n2_map_f, n0_jumps_i, wd, 0, 0), wd, 0, sp->transition_list, density);
+                      } else {
+                        trace_a22_nodes(a, b, c, d, num_mj_i, p2_jumps_i, n2_jumps_f, wd, 0, sp->transition_list, density);
+                      }
                     }  
                   } else if ((mt3 == -0.5) && (mt4 == -0.5)) {
                     if ((mt1 == -0.5) && (mt2 == -0.5)) { //2 n cr. and 2 n ann. operators
-                      trace_a4_nodes(a, b, c, d, num_mj_i, n_sds_n_int2, n2_array_f, n2_list_i, p0_list_i, wd, 1, sp->transition_list, density);
+                      if (compose) {
+                        trace_a4_nodes_compose(a, b, c, d, num_mj_i, n2_map_f, n1_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
+                      } else {
+                        trace_a4_nodes(a, b, c, d, num_mj_i, n2_map_f, n2_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
+                      }
                     } else if ((mt1 == 0.5) && (mt2 == 0.5)) {// 2 p cr. and 2 n ann. operators
                       if ((fabs(mj1 + mj2) > (mj_max_p_i - mj_min_p_i)) || (fabs(mj3 + mj4) > (mj_max_n_i - mj_min_n_i))) {printf("Saved time\n");continue;}
-                      trace_a22_nodes(a, b, c, d, num_mj_i, n2_list_i, p2_list_f, wd, 1, sp->transition_list, density);
+                      if (compose) {
+                        trace_a22_nodes_compose(a, b, c, d, num_mj_i, n1_jumps_i, pair_jumps_get(&pairs, a, b, num_mj_i, p2_map_f, p0_jumps_i, wd, 1, 0), wd, 1, sp->transition_list, density);
+                      } else {
+                        trace_a22_nodes(a, b, c, d, num_mj_i, n2_jumps_i, p2_jumps_f, wd, 1, sp->transition_list, density);
+                      }
                     }
                   } else if ((mt1 == 0.5) && (mt2 == -0.5) && (mt3 == 0.5) && (mt4 == -0.5)) {
-                      trace_a20_nodes(a, d, b, c, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(a, d, b, c, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                       for (int i = 0; i < sp->n_trans; i++) {density[i] *= -1.0;}
                   } else if ((mt1 == -0.5) && (mt2 == 0.5) && (mt3 == 0.5) && (mt4 == -0.5)) {
-                      trace_a20_nodes(b, d, a, c, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(b, d, a, c, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                   } else if ((mt1 == 0.5) && (mt2 == -0.5) && (mt3 == -0.5) && (mt4 == 0.5)) {
-                      trace_a20_nodes(a, c, b, d, num_mj_i, n_sds_p_int1, n_sds_n_int1,p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(a, c, b, d, num_mj_i,p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                   } else if ((mt1 == -0.5) && (mt2 == 0.5) && (mt3 == -0.5) && (mt4 == 0.5)) {
-                      trace_a20_nodes(b, c, a, d, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(b, c, a, d, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                       for (int i = 0; i < sp->n_trans; i++) {density[i] *= -1.0;}
                   }
                   for (int j12 = j_min_12; j12 <= j_max_12; j12++) {
@@ -671,6 +794,19 @@ void two_body_density_trunc(speedParams *sp) {
   } 
   free(j_store); 
 
+  report_lookup_stats(wd);
+  free(cg_fact);
+  free(density);
+  pair_jumps_free(&pairs);
+  arena_free(jump_arena);
+  rev_map_free(p1_map_f);
+  rev_map_free(p2_map_f);
+  if (!share_f) {
+    rev_map_free(n1_map_f);
+    rev_map_free(n2_map_f);
+  }
+  wfn_data_free(wd);
+
   return;
 }
 
@@ -730,47 +866,86 @@ void two_body_density(speedParams *sp) {
   printf("Number of m_j sectors:%d\n", num_mj_i);
   printf("%g, %g, %g, %g\n", mj_min_p_i, mj_max_p_i, mj_min_n_i, mj_max_n_i);
 
-  // Allocate space for jump lists
-  wf_list **p0_list_i = (wf_list**) calloc(2*num_mj_i, sizeof(wf_list*));
-  wf_list **n0_list_i = (wf_list**) calloc(2*num_mj_i, sizeof(wf_list*));
-  sd_list **p1_list_i = (sd_list**) calloc(2*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **n1_list_i = (sd_list**) calloc(2*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **p2_list_i = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **n2_list_i = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **p2_list_f = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  sd_list **n2_list_f = (sd_list**) calloc(2*ns*ns*num_mj_i, sizeof(sd_list*));
-  int* p1_array_f = (int*) calloc(ns*n_sds_p_int1, sizeof(int));
-  int* p2_array_f = (int*) calloc(ns*ns*n_sds_p_int2, sizeof(int));
-  int* n1_array_f = (int*) calloc(ns*n_sds_n_int1, sizeof(int));
-  int* n2_array_f = (int*) calloc(ns*ns*n_sds_n_int2, sizeof(int));
+  // Jumps are built once and shared by both species when their builders see the same SDs
+  jump_key p_key_i = {ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, -1, wd->n_sds_p_i, wd->present_p_i};
+  jump_key n_key_i = {ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, -1, wd->n_sds_n_i, wd->present_n_i};
+  jump_key p_key_f = {ns, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, -1, wd->n_sds_p_f, wd->present_p_f};
+  jump_key n_key_f = {ns, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, -1, wd->n_sds_n_f, wd->present_n_f};
+  int share_i = jump_keys_match(&p_key_i, &n_key_i);
+  int share_f = (wd->same_basis) ? share_i : jump_keys_match(&p_key_f, &n_key_f);
+  // Only the tables and maps of the trace kernels the operator reaches are built
+  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
+  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
+  float mt_op = mtf - mti;
+  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
+  // Two-body lists hold about ns times the entries of the one-body lists, the traces can compose them instead
+  int compose = TWO_BODY_COMPOSE;
+  // Created-species jumps of the composed a22 trace, shared by every (c, d) of a pair (a, b)
+  pair_jumps pairs = {-1, -1, -1, NULL};
+  jump_plan plan = plan_two_body_jumps(mt_op, compose, share_i, share_f);
+  log_jump_plan(&plan, wd, num_mj_i, 0);
+  // Allocate space for jump lists, released together with their arena once the densities are written
+  arena *jump_arena = arena_create((size_t) ARENA_BLOCK_MB*1024*1024);
+  jump_table *p0_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(0), 2*num_mj_i, 0, 0);
+  jump_table *n0_jumps_i = share_i ? p0_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(0), 2*num_mj_i, 0, 0);
+  jump_table *p1_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(1), 2*ns*num_mj_i, 1, 0);
+  jump_table *n1_jumps_i = share_i ? p1_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(1), 2*ns*num_mj_i, 1, 0);
+  jump_table *p2_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  jump_table *n2_jumps_i = share_i ? p2_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  jump_table *p2_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[0] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  jump_table *n2_jumps_f = share_f ? p2_jumps_f : jump_table_planned(jump_arena, plan.jumps_f[1] & PLAN_A(2), 2*ns*ns*num_mj_i, 1, 0);
+  rev_map* p1_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(1), ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+  rev_map* p2_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(2), ns, wd->n_proton_f - 2, 2, REV_MAP_MODE);
+  rev_map* n1_map_f = share_f ? p1_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(1), ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
+  rev_map* n2_map_f = share_f ? p2_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(2), ns, wd->n_neutron_f - 2, 2, REV_MAP_MODE);
 
   // Determine one/two-body jumps, using special routine if initial and final bases are the same
   if (wd->same_basis) {
-    printf("Building proton jumps...\n");
-    build_two_body_jumps_i_and_f(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, n_sds_p_int1, n_sds_p_int2, p1_array_f, p2_array_f, p0_list_i, p1_list_i, p2_list_i, wd->jz_shell, wd->l_shell);
-    printf("Done.\n");
-    printf("Building neutron jumps...\n");
-    build_two_body_jumps_i_and_f(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n_sds_n_int1, n_sds_n_int2, n1_array_f, n2_array_f, n0_list_i, n1_list_i, n2_list_i, wd->jz_shell, wd->l_shell);
-    printf("Done.\n");
+    if (plan.jumps_i[0] || plan.maps_f[0]) {
+      printf("Building proton jumps...\n");
+      build_two_body_jumps_i_and_f(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p1_map_f, p2_map_f, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+      printf("Done.\n");
+    }
+    if (share_i) {
+      printf("Neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1] || plan.maps_f[1]) {
+        printf("Building neutron jumps...\n");
+        build_two_body_jumps_i_and_f(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n1_map_f, n2_map_f, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+        printf("Done.\n");
+      }
+    }
   } else {
-    printf("Building initial state proton jumps...\n");
-    build_two_body_jumps_i(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_list_i, p1_list_i, p2_list_i, wd->jz_shell, wd->l_shell);
-    printf("Done\n");
-    printf("Building final state proton jumps...\n");
-    build_two_body_jumps_f(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, n_sds_p_int1, n_sds_p_int2, p1_array_f, p2_array_f, p2_list_f, wd->jz_shell, wd->l_shell);
-    printf("Done\n");
-    printf("Building initial state neutron jumps...\n");
-    build_two_body_jumps_i(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_list_i, n1_list_i, n2_list_i, wd->jz_shell, wd->l_shell);
-    printf("Building final state neutron jumps...\n");
-    build_two_body_jumps_f(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n_sds_n_int1, n_sds_n_int2, n1_array_f, n2_array_f, n2_list_f, wd->jz_shell, wd->l_shell);
+    if (plan.jumps_i[0]) {
+      printf("Building initial state proton jumps...\n");
+      build_two_body_jumps_i(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, p2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+      printf("Done\n");
+    }
+    if (plan.jumps_f[0] || plan.maps_f[0]) {
+      printf("Building final state proton jumps...\n");
+      build_two_body_jumps_f(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, p1_map_f, p2_map_f, p2_jumps_f, wd->jz_shell, wd->l_shell, wd->present_p_f);
+      printf("Done\n");
+    }
+    if (share_i) {
+      printf("Initial state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1]) {
+        printf("Building initial state neutron jumps...\n");
+        build_two_body_jumps_i(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, n2_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+      }
+    }
+    if (share_f) {
+      printf("Final state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_f[1] || plan.maps_f[1]) {
+        printf("Building final state neutron jumps...\n");
+        build_two_body_jumps_f(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n1_map_f, n2_map_f, n2_jumps_f, wd->jz_shell, wd->l_shell, wd->present_n_f);
+      }
+    }
     printf("Done.\n");
   }
 
   double* cg_fact = (double*) calloc(sp->n_trans, sizeof(double));
-  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
-  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
-  float mt_op = mtf - mti;
-  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
   FILE *out_file;
   char output_density_file[100];
   char output_log_file[100];
@@ -895,27 +1070,43 @@ void two_body_density(speedParams *sp) {
                   for (int i = 0; i < sp->n_trans; i++) {density[i] = 0.0;}
                   if ((mt3 == 0.5) && (mt4 == 0.5)) { // 
                     if ((mt1 == 0.5) && (mt2 == 0.5)) { // 2 proton creation operators + 2 proton annihilation operators
-                      trace_a4_nodes(a, b, c, d, num_mj_i, n_sds_p_int2, p2_array_f, p2_list_i, n0_list_i, wd, 0, sp->transition_list, density);
+                      if (compose) {
+                        trace_a4_nodes_compose(a, b, c, d, num_mj_i, p2_map_f, p1_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
+                      } else {
+                        trace_a4_nodes(a, b, c, d, num_mj_i, p2_map_f, p2_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
+                      }
                     } else if ((mt1 == -0.5) && (mt2 == -0.5)) { // 2 neutron creation operators and two proton ann. operators
                       if ((fabs(mj1 + mj2) > (mj_max_n_i - mj_min_n_i)) || (fabs(mj3 + mj4) > (mj_max_p_i - mj_min_p_i))) {printf("Saved time\n"); continue;}
-                      trace_a22_nodes(a, b, c, d, num_mj_i, p2_list_i, n2_list_f, wd, 0, sp->transition_list, density);
+                      if (compose) {
+                        trace_a22_nodes_compose(a, b, c, d, num_mj_i, p1_jumps_i, pair_jumps_get(&pairs, a, b, num_mj_i, n2_map_f, n0_jumps_i, wd, 0, 0), wd, 0, sp->transition_list, density);
+                      } else {
+                        trace_a22_nodes(a, b, c, d, num_mj_i, p2_jumps_i, n2_jumps_f, wd, 0, sp->transition_list, density);
+                      }
                     }  
                   } else if ((mt3 == -0.5) && (mt4 == -0.5)) {
                     if ((mt1 == -0.5) && (mt2 == -0.5)) { //2 n cr. and 2 n ann. operators
-                      trace_a4_nodes(a, b, c, d, num_mj_i, n_sds_n_int2, n2_array_f, n2_list_i, p0_list_i, wd, 1, sp->transition_list, density);
+                      if (compose) {
+                        trace_a4_nodes_compose(a, b, c, d, num_mj_i, n2_map_f, n1_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
+                      } else {
+                        trace_a4_nodes(a, b, c, d, num_mj_i, n2_map_f, n2_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
+                      }
                     } else if ((mt1 == 0.5) && (mt2 == 0.5)) {// 2 p cr. and 2 n ann. operators
                       if ((fabs(mj1 + mj2) > (mj_max_p_i - mj_min_p_i)) || (fabs(mj3 + mj4) > (mj_max_n_i - mj_min_n_i))) {printf("Saved time\n");continue;}
-                      trace_a22_nodes(a, b, c, d, num_mj_i, n2_list_i, p2_list_f, wd, 1, sp->transition_list, density);
+                      if (compose) {
+                        trace_a22_nodes_compose(a, b, c, d, num_mj_i, n1_jumps_i, pair_jumps_get(&pairs, a, b, num_mj_i, p2_map_f, p0_jumps_i, wd, 1, 0), wd, 1, sp->transition_list, density);
+                      } else {
+                        trace_a22_nodes(a, b, c, d, num_mj_i, n2_jumps_i, p2_jumps_f, wd, 1, sp->transition_list, density);
+                      }
                     }
                   } else if ((mt1 == 0.5) && (mt2 == -0.5) && (mt3 == 0.5) && (mt4 == -0.5)) {
-                      trace_a20_nodes(a, d, b, c, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(a, d, b, c, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                       for (int i = 0; i < sp->n_trans; i++) {density[i] *= -1.0;}
                   } else if ((mt1 == -0.5) && (mt2 == 0.5) && (mt3 == 0.5) && (mt4 == -0.5)) {
-                      trace_a20_nodes(b, d, a, c, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(b, d, a, c, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                   } else if ((mt1 == 0.5) && (mt2 == -0.5) && (mt3 == -0.5) && (mt4 == 0.5)) {
-                      trace_a20_nodes(a, c, b, d, num_mj_i, n_sds_p_int1, n_sds_n_int1,p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(a, c, b, d, num_mj_i,p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                   } else if ((mt1 == -0.5) && (mt2 == 0.5) && (mt3 == -0.5) && (mt4 == 0.5)) {
-                      trace_a20_nodes(b, c, a, d, num_mj_i, n_sds_p_int1, n_sds_n_int1, p1_list_i, n1_list_i, p1_array_f, n1_array_f, wd, sp->transition_list, density);
+                      trace_a20_nodes(b, c, a, d, num_mj_i, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, sp->transition_list, density);
                       for (int i = 0; i < sp->n_trans; i++) {density[i] *= -1.0;}
                   }
                   for (int j12 = j_min_12; j12 <= j_max_12; j12++) {
@@ -1006,6 +1197,19 @@ void two_body_density(speedParams *sp) {
   } 
   free(j_store); 
 
+  report_lookup_stats(wd);
+  free(cg_fact);
+  free(density);
+  pair_jumps_free(&pairs);
+  arena_free(jump_arena);
+  rev_map_free(p1_map_f);
+  rev_map_free(p2_map_f);
+  if (!share_f) {
+    rev_map_free(n1_map_f);
+    rev_map_free(n2_map_f);
+  }
+  wfn_data_free(wd);
+
   return;
 }
 void one_body_density_spec(speedParams *sp) {
@@ -1062,45 +1266,70 @@ void one_body_density_spec(speedParams *sp) {
   printf("Num spec bins: %d\n", n_spec_bins);
   double* density = calloc(n_spec_bins*sp->n_trans, sizeof(double));
   double* total = calloc(n_spec_bins*sp->n_trans*pow(wd->n_orbits, 2), sizeof(double));
+  if ((density == NULL) || (total == NULL)) {printf("Error allocating density buffers\n"); exit(0);}
   printf("Min spec excitations: %d Max spec excitations: %d\n", min_n_spec_q, max_n_spec_q);
 
-  // Allocate space for jump lists
-  wfe_list **p0_list_i = (wfe_list**) calloc(2*num_mj_i, sizeof(wfe_list*));
-  wfe_list **n0_list_i = (wfe_list**) calloc(2*num_mj_i, sizeof(wfe_list*));
-  sde_list **p1_list_i = (sde_list**) calloc(2*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **n1_list_i = (sde_list**) calloc(2*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **p1_list_f = (sde_list**) calloc(2*ns*num_mj_i, sizeof(sde_list*));
-  sde_list **n1_list_f = (sde_list**) calloc(2*ns*num_mj_i, sizeof(sde_list*));
-  int* p1_array_f = (int*) calloc(ns*n_sds_p_int, sizeof(int));
-  int* n1_array_f = (int*) calloc(ns*n_sds_n_int, sizeof(int));
+  // Jumps are built once and shared by both species when their builders see the same SDs
+  jump_key p_key = {ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, -1, wd->n_sds_p_i, wd->present_p_i};
+  jump_key n_key = {ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, -1, wd->n_sds_n_i, wd->present_n_i};
+  int share = wd->same_basis && jump_keys_match(&p_key, &n_key);
+  // Only the tables and maps of the trace kernels the operator reaches are built
+  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
+  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
+  float mt_op = mtf - mti;
+  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
+  jump_plan plan = plan_one_body_jumps(mt_op, 0, share, share);
+  log_jump_plan(&plan, wd, num_mj_i, 1);
+  // Allocate space for jump lists, released together with their arena once the densities are written
+  arena *jump_arena = arena_create((size_t) ARENA_BLOCK_MB*1024*1024);
+  jump_table *p0_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(0), 2*num_mj_i, 0, 1);
+  jump_table *n0_jumps_i = share ? p0_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(0), 2*num_mj_i, 0, 1);
+  jump_table *p1_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(1), 2*ns*num_mj_i, 1, 1);
+  jump_table *n1_jumps_i = share ? p1_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(1), 2*ns*num_mj_i, 1, 1);
+  jump_table *p1_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[0] & PLAN_A(1), 2*ns*num_mj_i, 1, 1);
+  jump_table *n1_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[1] & PLAN_A(1), 2*ns*num_mj_i, 1, 1);
+  rev_map* p1_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(1), ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+  rev_map* n1_map_f = share ? p1_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(1), ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
 
   if (wd->same_basis) {
-    printf("Building initial and final state proton jumps...\n");
-    build_one_body_jumps_i_and_f_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, n_sds_p_int, p1_array_f, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell, wd->n_shell); 
-    printf("Done.\n");
+    if (plan.jumps_i[0] || plan.maps_f[0]) {
+      printf("Building initial and final state proton jumps...\n");
+      build_one_body_jumps_i_and_f_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p1_map_f, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_p_i);
+      printf("Done.\n");
+    }
 
-    printf("Building initial and final state neutron jumps...\n");
-    build_one_body_jumps_i_and_f_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n_sds_n_int, n1_array_f, n0_list_i, n1_list_i, wd->jz_shell, wd->l_shell, wd->n_shell); 
-    printf("Done.\n");
+    if (share) {
+      printf("Neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1] || plan.maps_f[1]) {
+        printf("Building initial and final state neutron jumps...\n");
+        build_one_body_jumps_i_and_f_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n1_map_f, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_n_i);
+        printf("Done.\n");
+      }
+    }
   } else {
-    printf("Building initial state proton jumps...\n");
-    build_one_body_jumps_i_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done.\n");
-    printf("Building final state proton jumps...\n");
-    build_one_body_jumps_f_spec(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, n_sds_p_int, p1_array_f, p1_list_f, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done.\n");
-    printf("Building initial state neutron jumps...\n");
-    build_one_body_jumps_i_spec(wd->n_shells, wd->n_proton_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_p_i, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done.\n"); 
-    printf("Building final state neutron jumps...\n");
-    build_one_body_jumps_f_spec(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n_sds_n_int, n1_array_f, n1_list_f, wd->jz_shell, wd->l_shell, wd->n_shell);
-    printf("Done.\n");
+    if (plan.jumps_i[0]) {
+      printf("Building initial state proton jumps...\n");
+      build_one_body_jumps_i_spec(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_p_i);
+      printf("Done.\n");
+    }
+    if (plan.jumps_f[0] || plan.maps_f[0]) {
+      printf("Building final state proton jumps...\n");
+      build_one_body_jumps_f_spec(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_i, wd->n_sds_p_f, p1_map_f, p1_jumps_f, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_p_f);
+      printf("Done.\n");
+    }
+    if (plan.jumps_i[1]) {
+      printf("Building initial state neutron jumps...\n");
+      build_one_body_jumps_i_spec(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_n_i);
+      printf("Done.\n");
+    }
+    if (plan.jumps_f[1] || plan.maps_f[1]) {
+      printf("Building final state neutron jumps...\n");
+      build_one_body_jumps_f_spec(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_i, wd->n_sds_n_f, n1_map_f, n1_jumps_f, wd->jz_shell, wd->l_shell, wd->n_shell, wd->present_n_f);
+      printf("Done.\n");
+    }
   } 
   double* cg_fact = (double*) calloc(sp->n_trans, sizeof(double));
-  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
-  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
-  float mt_op = mtf - mti;
-  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
   // Loop over transitions
   eigen_list* trans = sp->transition_list;
   int i_trans = 0;
@@ -1161,13 +1390,13 @@ void one_body_density_spec(speedParams *sp) {
           }
 
           if ((mt1 == 0.5) && (mt2 == 0.5)) {
-            trace_1body_t0_nodes_spec(a, b, num_mj_i, n_sds_p_int, p1_array_f, p1_list_i, n0_list_i, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+            trace_1body_t0_nodes_spec(a, b, num_mj_i, p1_map_f, p1_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
           } else if ((mt1 == -0.5) && (mt2 == -0.5)) {
-            trace_1body_t0_nodes_spec(a, b, num_mj_i, n_sds_n_int, n1_array_f, n1_list_i, p0_list_i, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+            trace_1body_t0_nodes_spec(a, b, num_mj_i, n1_map_f, n1_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
           } else if ((mt1 == 0.5) && (mt2 == -0.5)) {
-            trace_1body_t2_nodes_spec(a, b, num_mj_i, n1_list_i, p1_list_f, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+            trace_1body_t2_nodes_spec(a, b, num_mj_i, n1_jumps_i, p1_jumps_f, wd, 0, sp->transition_list, density, min_n_spec_q, n_spec_bins);
           } else {
-            trace_1body_t2_nodes_spec(a, b, num_mj_i, p1_list_i, n1_list_f, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
+            trace_1body_t2_nodes_spec(a, b, num_mj_i, p1_jumps_i, n1_jumps_f, wd, 1, sp->transition_list, density, min_n_spec_q, n_spec_bins);
           }
           for (int i = 0; i < sp->n_trans; i++) {
             for (int j = 0; j < n_spec_bins; j++) {
@@ -1208,6 +1437,15 @@ void one_body_density_spec(speedParams *sp) {
     i_trans++;
     trans = trans->next;
   }   
+  report_lookup_stats(wd);
+  free(cg_fact);
+  free(density);
+  free(total);
+  arena_free(jump_arena);
+  rev_map_free(p1_map_f);
+  if (!share) {rev_map_free(n1_map_f);}
+  wfn_data_free(wd);
+
   return;
 }
 
@@ -1300,46 +1538,83 @@ void one_body_density_trunc(speedParams* sp) {
   printf("Number of final m_j sectors: %d %d\n", num_mj_p_f, num_mj_n_f);
   printf("%g, %g, %g, %g\n", mj_min_p_f, mj_max_p_f, mj_min_n_f, mj_max_n_f);
 
-  // Allocate space for jump lists
-  wf_list **p0_list_i = (wf_list**) calloc(2*num_mj_p_i, sizeof(wf_list*));
-  wf_list **n0_list_i = (wf_list**) calloc(2*num_mj_n_i, sizeof(wf_list*));
-  sd_list **p1_list_i = (sd_list**) calloc(2*ns*num_mj_p_i, sizeof(sd_list*));
-  sd_list **n1_list_i = (sd_list**) calloc(2*ns*num_mj_n_i, sizeof(sd_list*));
-  sd_list **p1_list_f = (sd_list**) calloc(2*ns*num_mj_p_i, sizeof(sd_list*));
-  sd_list **n1_list_f = (sd_list**) calloc(2*ns*num_mj_n_i, sizeof(sd_list*));
-  int* p1_array_f = (int*) calloc(ns*n_sds_p_int, sizeof(int));
-  int* n1_array_f = (int*) calloc(ns*n_sds_n_int, sizeof(int));
+  // Jumps are built once and shared by both species when their builders see the same SDs
   int w_cut = 51;
+  jump_key p_key = {ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, w_cut, wd->n_sds_p_i, wd->present_p_i};
+  jump_key n_key = {ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, w_cut, wd->n_sds_n_i, wd->present_n_i};
+  int share = wd->same_basis && jump_keys_match(&p_key, &n_key);
+  // Only the tables and maps of the trace kernels the operator reaches are built
+  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
+  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
+  float mt_op = mtf - mti;
+  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
+  // Same-species operators act within one basis, where they can be listed as direct a+a jumps
+  int one_hop = ONE_BODY_HOPS && wd->same_basis && (sd_mask_words(ns) > 0);
+  jump_plan plan = plan_one_body_jumps(mt_op, one_hop, share, share);
+  log_jump_plan(&plan, wd, num_mj_p_i, 0);
+  // Allocate space for jump lists, released together with their arena once the densities are written
+  arena *jump_arena = arena_create((size_t) ARENA_BLOCK_MB*1024*1024);
+  jump_table *p0_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(0), 2*num_mj_p_i, 0, 0);
+  jump_table *n0_jumps_i = share ? p0_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(0), 2*num_mj_n_i, 0, 0);
+  jump_table *p1_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(1), 2*ns*num_mj_p_i, 1, 0);
+  jump_table *n1_jumps_i = share ? p1_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(1), 2*ns*num_mj_n_i, 1, 0);
+  jump_table *p1_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[0] & PLAN_A(1), 2*ns*num_mj_p_i, 1, 0);
+  jump_table *n1_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[1] & PLAN_A(1), 2*ns*num_mj_n_i, 1, 0);
+  jump_table *p11_jumps_i = NULL;
+  jump_table *n11_jumps_i = NULL;
+  rev_map* p1_map_f = NULL;
+  rev_map* n1_map_f = NULL;
+  if (one_hop) {
+    p11_jumps_i = jump_table_planned(jump_arena, plan.hops_i[0], checked_count(2*ns, ns, num_mj_p_i), 1, 0);
+    n11_jumps_i = share ? p11_jumps_i : jump_table_planned(jump_arena, plan.hops_i[1], checked_count(2*ns, ns, num_mj_n_i), 1, 0);
+  } else {
+    p1_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(1), ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+    n1_map_f = share ? p1_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(1), ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
+  }
   if (wd->same_basis) {
-    printf("Building initial and final state proton jumps...\n");
-    build_one_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, n_sds_p_int, p1_array_f, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut); 
-    printf("Done.\n");
+    if (plan.jumps_i[0] || plan.maps_f[0]) {
+      printf("Building initial and final state proton jumps...\n");
+      build_one_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p1_map_f, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_p_i);
+      if (plan.hops_i[0]) {build_one_body_hops_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p11_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_p_i);}
+      printf("Done.\n");
+    }
 
-    printf("Building initial and final state neutron jumps...\n");
-    build_one_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n_sds_n_int, n1_array_f, n0_list_i, n1_list_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut); 
-    printf("Done.\n");
+    if (share) {
+      printf("Neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1] || plan.maps_f[1]) {
+        printf("Building initial and final state neutron jumps...\n");
+        build_one_body_jumps_i_and_f_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n1_map_f, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_n_i);
+        if (plan.hops_i[1]) {build_one_body_hops_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n11_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, w_cut, wd->present_n_i);}
+        printf("Done.\n");
+      }
+    }
   } else {
-    printf("Building initial state proton jumps...\n");
-    build_one_body_jumps_i_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell, wd->w_shell, 15);
-    printf("Done.\n");
-    printf("Building final state proton jumps...\n");
-    build_one_body_jumps_f_trunc(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_f, n_sds_p_int, p1_array_f, p1_list_f, wd->jz_shell, wd->l_shell, wd->w_shell, 18);
-    printf("Done.\n");
-    printf("Building initial state neutron jumps...\n");
-    build_one_body_jumps_i_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n0_list_i, n1_list_i, wd->jz_shell, wd->l_shell, wd->w_shell, 42);
-    printf("Done.\n"); 
-    printf("Building final state neutron jumps...\n");
-    build_one_body_jumps_f_trunc(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_f, n_sds_n_int, n1_array_f, n1_list_f, wd->jz_shell, wd->l_shell, wd->w_shell, 39);
-    printf("Done.\n");
+    if (plan.jumps_i[0]) {
+      printf("Building initial state proton jumps...\n");
+      build_one_body_jumps_i_trunc(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, 15, wd->present_p_i);
+      printf("Done.\n");
+    }
+    if (plan.jumps_f[0] || plan.maps_f[0]) {
+      printf("Building final state proton jumps...\n");
+      build_one_body_jumps_f_trunc(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_f, p1_map_f, p1_jumps_f, wd->jz_shell, wd->l_shell, wd->w_shell, 18, wd->present_p_f);
+      printf("Done.\n");
+    }
+    if (plan.jumps_i[1]) {
+      printf("Building initial state neutron jumps...\n");
+      build_one_body_jumps_i_trunc(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->w_shell, 42, wd->present_n_i);
+      printf("Done.\n");
+    }
+    if (plan.jumps_f[1] || plan.maps_f[1]) {
+      printf("Building final state neutron jumps...\n");
+      build_one_body_jumps_f_trunc(wd->n_shells, wd->n_neutron_f, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_f, n1_map_f, n1_jumps_f, wd->jz_shell, wd->l_shell, wd->w_shell, 39, wd->present_n_f);
+      printf("Done.\n");
+    }
   } 
   // Loop over initial eigenstates
   
  
   double* cg_fact = (double*) calloc(sp->n_trans, sizeof(double));
-  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
-  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
-  float mt_op = mtf - mti;
-  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
   // Loop over transitions
   eigen_list* trans = sp->transition_list;
   int i_trans = 0;
@@ -1371,6 +1646,7 @@ void one_body_density_trunc(speedParams* sp) {
   // Loop over final state orbits
   double *total = (double*) calloc(sp->n_trans*pow(wd->n_orbits, 2), sizeof(double));
   double *density = (double*) calloc(sp->n_trans, sizeof(double));
+  if ((density == NULL) || (total == NULL)) {printf("Error allocating density buffers\n"); exit(0);}
   for (int i_orb1 = 0; i_orb1 < wd->n_orbits; i_orb1++) {
     float j1 = wd->j_orb[i_orb1];
     // Loop over initial state orbits
@@ -1402,14 +1678,18 @@ void one_body_density_trunc(speedParams* sp) {
           for (int i = 0; i < sp->n_trans; i++) {
             density[i] = 0.0;
           }
-          if ((mt1 == 0.5) && (mt2 == 0.5)) {
-            trace_1body_t0_nodes(a, b, num_mj_p_i, n_sds_p_int, p1_array_f, p1_list_i, n0_list_i, wd, 0, sp->transition_list, density);
+          if ((mt1 == 0.5) && (mt2 == 0.5) && one_hop) {
+            trace_1body_t0_hops(a, b, num_mj_p_i, p11_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
+          } else if ((mt1 == -0.5) && (mt2 == -0.5) && one_hop) {
+            trace_1body_t0_hops(a, b, num_mj_n_i, n11_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
+          } else if ((mt1 == 0.5) && (mt2 == 0.5)) {
+            trace_1body_t0_nodes(a, b, num_mj_p_i, p1_map_f, p1_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
           } else if ((mt1 == -0.5) && (mt2 == -0.5)) {
-            trace_1body_t0_nodes(a, b, num_mj_n_i, n_sds_n_int, n1_array_f, n1_list_i, p0_list_i, wd, 1, sp->transition_list, density);
+            trace_1body_t0_nodes(a, b, num_mj_n_i, n1_map_f, n1_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
           } else if ((mt1 == 0.5) && (mt2 == -0.5)) {
-            trace_1body_t2_nodes(a, b, num_mj_n_i, mj_min_n_i, num_mj_p_i, mj_min_p_i, n1_list_i, p1_list_f, wd, 1, sp->transition_list, density);
+            trace_1body_t2_nodes(a, b, num_mj_n_i, mj_min_n_i, num_mj_p_i, mj_min_p_i, n1_jumps_i, p1_jumps_f, wd, 1, sp->transition_list, density);
           } else {
-            trace_1body_t2_nodes(a, b, num_mj_p_i, mj_min_p_i, num_mj_n_i, mj_min_n_i, p1_list_i, n1_list_f, wd, 0, sp->transition_list, density);
+            trace_1body_t2_nodes(a, b, num_mj_p_i, mj_min_p_i, num_mj_n_i, mj_min_n_i, p1_jumps_i, n1_jumps_f, wd, 0, sp->transition_list, density);
           }
           for (int i = 0; i < sp->n_trans; i++) {
             total[i + sp->n_trans*(i_orb1 + i_orb2*wd->n_orbits)] += density[i]*d2/cg_fact[i];
@@ -1448,6 +1728,15 @@ void one_body_density_trunc(speedParams* sp) {
     trans = trans->next;
   }    
   
+  report_lookup_stats(wd);
+  free(cg_fact);
+  free(density);
+  free(total);
+  arena_free(jump_arena);
+  rev_map_free(p1_map_f);
+  if (!share) {rev_map_free(n1_map_f);}
+  wfn_data_free(wd);
+
   return;
 }
 
@@ -1522,47 +1811,82 @@ void one_body_density(speedParams* sp) {
   printf("Number of final n m_j sectors:%d\n", num_mj_n_f);
 
 
-  // Allocate space for jump lists
-  wf_list **p0_list_i = (wf_list**) calloc(2*num_mj_p_i, sizeof(wf_list*));
-  wf_list **n0_list_i = (wf_list**) calloc(2*num_mj_n_i, sizeof(wf_list*));
-  sd_list **p1_list_i = (sd_list**) calloc(2*ns*num_mj_p_i, sizeof(sd_list*));
-  sd_list **n1_list_i = (sd_list**) calloc(2*ns*num_mj_n_i, sizeof(sd_list*));
-  sd_list **p1_list_f = (sd_list**) calloc(2*ns*num_mj_f, sizeof(sd_list*));
-  sd_list **n1_list_f = (sd_list**) calloc(2*ns*num_mj_f, sizeof(sd_list*));
-  int* p1_array_f = (int*) calloc(ns*n_sds_p_int, sizeof(int));
-  int* n1_array_f = (int*) calloc(ns*n_sds_n_int, sizeof(int));
+  // Jumps are built once and shared by both species when their builders see the same SDs
+  jump_key p_key_i = {ns, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, -1, wd->n_sds_p_i, wd->present_p_i};
+  jump_key n_key_i = {ns, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, -1, wd->n_sds_n_i, wd->present_n_i};
+  jump_key p_key_f = {ns, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_p_i, -1, wd->n_sds_p_f, wd->present_p_f};
+  jump_key n_key_f = {ns, wd->n_neutron_f, mj_min_n_f, mj_max_n_i, num_mj_n_i, -1, wd->n_sds_n_i, NULL};
+  int share_i = jump_keys_match(&p_key_i, &n_key_i);
+  int share_f = (wd->same_basis) ? share_i : jump_keys_match(&p_key_f, &n_key_f);
+  // Only the tables and maps of the trace kernels the operator reaches are built
+  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
+  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
+  float mt_op = mtf - mti;
+  printf("mt_op: %g \n", mt_op);
+  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
+  jump_plan plan = plan_one_body_jumps(mt_op, 0, share_i, share_f);
+  log_jump_plan(&plan, wd, num_mj_p_i, 0);
+  // Allocate space for jump lists, released together with their arena once the densities are written
+  arena *jump_arena = arena_create((size_t) ARENA_BLOCK_MB*1024*1024);
+  jump_table *p0_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(0), 2*num_mj_p_i, 0, 0);
+  jump_table *n0_jumps_i = share_i ? p0_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(0), 2*num_mj_n_i, 0, 0);
+  jump_table *p1_jumps_i = jump_table_planned(jump_arena, plan.jumps_i[0] & PLAN_A(1), 2*ns*num_mj_p_i, 1, 0);
+  jump_table *n1_jumps_i = share_i ? p1_jumps_i : jump_table_planned(jump_arena, plan.jumps_i[1] & PLAN_A(1), 2*ns*num_mj_n_i, 1, 0);
+  jump_table *p1_jumps_f = jump_table_planned(jump_arena, plan.jumps_f[0] & PLAN_A(1), 2*ns*num_mj_f, 1, 0);
+  jump_table *n1_jumps_f = share_f ? p1_jumps_f : jump_table_planned(jump_arena, plan.jumps_f[1] & PLAN_A(1), 2*ns*num_mj_f, 1, 0);
+  rev_map* p1_map_f = rev_map_planned(plan.maps_f[0] & PLAN_A(1), ns, wd->n_proton_f - 1, 1, REV_MAP_MODE);
+  rev_map* n1_map_f = share_f ? p1_map_f : rev_map_planned(plan.maps_f[1] & PLAN_A(1), ns, wd->n_neutron_f - 1, 1, REV_MAP_MODE);
 
   if (wd->same_basis) {
-    printf("Building initial and final state proton jumps...\n");
-    build_one_body_jumps_i_and_f(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, n_sds_p_int, p1_array_f, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell); 
-    printf("Done.\n");
+    if (plan.jumps_i[0] || plan.maps_f[0]) {
+      printf("Building initial and final state proton jumps...\n");
+      build_one_body_jumps_i_and_f(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p1_map_f, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+      printf("Done.\n");
+    }
 
-    printf("Building initial and final state neutron jumps...\n");
-    build_one_body_jumps_i_and_f(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n_sds_n_int, n1_array_f, n0_list_i, n1_list_i, wd->jz_shell, wd->l_shell); 
-    printf("Done.\n");
+    if (share_i) {
+      printf("Neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1] || plan.maps_f[1]) {
+        printf("Building initial and final state neutron jumps...\n");
+        build_one_body_jumps_i_and_f(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n1_map_f, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+        printf("Done.\n");
+      }
+    }
   } else {
-    printf("Building initial state proton jumps...\n");
-    build_one_body_jumps_i(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p0_list_i, p1_list_i, wd->jz_shell, wd->l_shell);
-    printf("Done.\n");
-    printf("Building final state proton jumps...\n");
-    build_one_body_jumps_f(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_f, n_sds_p_int, p1_array_f, p1_list_f, wd->jz_shell, wd->l_shell);
-    printf("Done.\n");
-    printf("Building initial state neutron jumps...\n");
-    build_one_body_jumps_i(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n0_list_i, n1_list_i, wd->jz_shell, wd->l_shell);
-    printf("Done.\n"); 
-    printf("Building final state neutron jumps...\n");
-    build_one_body_jumps_f(wd->n_shells, wd->n_neutron_f, mj_min_n_f, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n_sds_n_int, n1_array_f, n1_list_f, wd->jz_shell, wd->l_shell);
-    printf("Done.\n");
+    if (plan.jumps_i[0]) {
+      printf("Building initial state proton jumps...\n");
+      build_one_body_jumps_i(wd->n_shells, wd->n_proton_i, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_i, p0_jumps_i, p1_jumps_i, wd->jz_shell, wd->l_shell, wd->present_p_i);
+      printf("Done.\n");
+    }
+    if (plan.jumps_f[0] || plan.maps_f[0]) {
+      printf("Building final state proton jumps...\n");
+      build_one_body_jumps_f(wd->n_shells, wd->n_proton_f, mj_min_p_i, mj_max_p_i, num_mj_p_i, wd->n_sds_p_f, p1_map_f, p1_jumps_f, wd->jz_shell, wd->l_shell, wd->present_p_f);
+      printf("Done.\n");
+    }
+    if (share_i) {
+      printf("Initial state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_i[1]) {
+        printf("Building initial state neutron jumps...\n");
+        build_one_body_jumps_i(wd->n_shells, wd->n_neutron_i, mj_min_n_i, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n0_jumps_i, n1_jumps_i, wd->jz_shell, wd->l_shell, wd->present_n_i);
+        printf("Done.\n");
+      }
+    }
+    if (share_f) {
+      printf("Final state neutron jumps are the same as the proton jumps\n");
+    } else {
+      if (plan.jumps_f[1] || plan.maps_f[1]) {
+        printf("Building final state neutron jumps...\n");
+        build_one_body_jumps_f(wd->n_shells, wd->n_neutron_f, mj_min_n_f, mj_max_n_i, num_mj_n_i, wd->n_sds_n_i, n1_map_f, n1_jumps_f, wd->jz_shell, wd->l_shell, NULL);
+        printf("Done.\n");
+      }
+    }
   } 
   // Loop over initial eigenstates
   
   
   double* cg_fact = (double*) calloc(sp->n_trans, sizeof(double));
-  float mti = 0.5*(wd->n_proton_i - wd->n_neutron_i);
-  float mtf = 0.5*(wd->n_proton_f - wd->n_neutron_f);
-  float mt_op = mtf - mti;
-  printf("mt_op: %g \n", mt_op);
-  if (fabs(mt_op) > t_op) {printf("Error: operator iso-spin is insufficient to mediate a transition between the given nuclides.\n"); exit(0);}
   // Loop over transitions
   eigen_list* trans = sp->transition_list;
   int i_trans = 0;
@@ -1594,6 +1918,7 @@ void one_body_density(speedParams* sp) {
   // Loop over final state orbits
   double *total = (double*) calloc(sp->n_trans*pow(wd->n_orbits, 2), sizeof(double));
   double *density = (double*) calloc(sp->n_trans, sizeof(double));
+  if ((density == NULL) || (total == NULL)) {printf("Error allocating density buffers\n"); exit(0);}
   for (int i_orb1 = 0; i_orb1 < wd->n_orbits; i_orb1++) {
     float j1 = wd->j_orb[i_orb1];
     // Loop over initial state orbits
@@ -1626,13 +1951,13 @@ void one_body_density(speedParams* sp) {
             density[i] = 0.0;
           }
           if ((mt1 == 0.5) && (mt2 == 0.5)) {
-            trace_1body_t0_nodes(a, b, num_mj_p_i, n_sds_p_int, p1_array_f, p1_list_i, n0_list_i, wd, 0, sp->transition_list, density);
+            trace_1body_t0_nodes(a, b, num_mj_p_i, p1_map_f, p1_jumps_i, n0_jumps_i, wd, 0, sp->transition_list, density);
           } else if ((mt1 == -0.5) && (mt2 == -0.5)) {
-            trace_1body_t0_nodes(a, b, num_mj_n_i, n_sds_n_int, n1_array_f, n1_list_i, p0_list_i, wd, 1, sp->transition_list, density);
+            trace_1body_t0_nodes(a, b, num_mj_n_i, n1_map_f, n1_jumps_i, p0_jumps_i, wd, 1, sp->transition_list, density);
           } else if ((mt1 == 0.5) && (mt2 == -0.5)) {
-            trace_1body_t2_nodes(a, b, num_mj_n_i, mj_min_n_i, num_mj_p_i, mj_min_p_i, n1_list_i, p1_list_f, wd, 1, sp->transition_list, density);
+            trace_1body_t2_nodes(a, b, num_mj_n_i, mj_min_n_i, num_mj_p_i, mj_min_p_i, n1_jumps_i, p1_jumps_f, wd, 1, sp->transition_list, density);
           } else {
-            trace_1body_t2_nodes(a, b, num_mj_p_i, mj_min_p_i, num_mj_n_i, mj_min_n_i, p1_list_i, n1_list_f, wd, 0, sp->transition_list, density);
+            trace_1body_t2_nodes(a, b, num_mj_p_i, mj_min_p_i, num_mj_n_i, mj_min_n_i, p1_jumps_i, n1_jumps_f, wd, 0, sp->transition_list, density);
           }
           for (int i = 0; i < sp->n_trans; i++) {
             total[i + sp->n_trans*(i_orb1 + i_orb2*wd->n_orbits)] += density[i]*d2/cg_fact[i];
@@ -1668,55 +1993,59 @@ void one_body_density(speedParams* sp) {
     trans = trans->next;
   }    
   
+  report_lookup_stats(wd);
+  free(cg_fact);
+  free(density);
+  free(total);
+  arena_free(jump_arena);
+  rev_map_free(p1_map_f);
+  if (!share_f) {rev_map_free(n1_map_f);}
+  wfn_data_free(wd);
+
   return;
 }
 
-void trace_a4_nodes(int a, int b, int c, int d, int num_mj, int n_sds_int2, int* p2_array_f, sd_list** p2_list_i, wf_list** n0_list_i, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+void trace_a4_nodes(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p2_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A4, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A4, a, b, c, d, i_op, 0);
+  }
   int ns = wd->n_shells;
 
   for (int ipar = 0; ipar <= 1; ipar++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sd_list* node1 = p2_list_i[ipar + 2*(imj + num_mj*(c + d*ns))];
-      while (node1 != NULL) {
-        unsigned int ppn = node1->pn;
-        unsigned int ppi = node1->pi;
-        int phase1 = node1->phase;
-        int ppf = p2_array_f[(ppn - 1) + n_sds_int2*(a + ns*b)];
-        if (ppf == 0) {node1 = node1->next; continue;}
+      size_t row1 = ipar + 2*(imj + num_mj*(c + d*ns));
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, p2_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppn = j1.pn;
+        unsigned int ppi = j1.pi;
+        int phase1 = j1.phase;
+        int ppf = rev_map_get(p2_map_f, ppn, a + ns*b);
+        if (ppf == 0) {continue;}
         int phase2 = 1;
-        node1 = node1->next;
         if (ppf < 0) {
           ppf *= -1;
           phase2 = -1;
         }
-        wf_list* node2 = n0_list_i[ipar + 2*(num_mj - imj - 1)];
-        while (node2 != NULL) {
-          int pn = node2->p;
-          int index_i = -1;
-          int index_f = -1;
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, n0_jumps_i, row2); jump_cursor_next(&j2);) {
+          int pn = j2.pi;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
 
           if (i_op == 0) {
-            unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pn % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pn == node3->pn) && (ppi == node3->pp)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pn % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pn == node3->pn) && (ppf == node3->pp)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_i = basis_lookup(wd->basis_i, ppi, pn);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pn);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -1727,27 +2056,12 @@ void trace_a4_nodes(int a, int b, int c, int d, int num_mj, int n_sds_int2, int*
               eig_pair = eig_pair->next;
             }
            } else {
-            unsigned int p_hash_i = pn + wd->n_sds_p_i*(ppi % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pn == node3->pp) && (ppi == node3->pn)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = pn + wd->n_sds_p_f*(ppf % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pn == node3->pp) && (ppf == node3->pn)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_i = basis_lookup(wd->basis_i, pn, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pn, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -1758,58 +2072,61 @@ void trace_a4_nodes(int a, int b, int c, int d, int num_mj, int n_sds_int2, int*
               eig_pair = eig_pair->next;
             }
           } 
-          node2 = node2->next;
         } 
       }
     }
    }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void trace_a22_nodes(int a, int b, int c, int d, int num_mj, sd_list** a2_list_i, sd_list** a2_list_f, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+void trace_a22_nodes(int a, int b, int c, int d, int num_mj, jump_table* a2_jumps_i, jump_table* a2_jumps_f, wfnData* wd, int i_op, eigen_list* transition, double* density) {
 /* 
 
 */
+  if (wd->join_a22) {
+    trace_a22_nodes_join(a, b, c, d, num_mj, a2_jumps_i, a2_jumps_f, wd, i_op, transition, density);
+    return;
+  }
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A22, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A22, a, b, c, d, i_op, 0);
+  }
   int ns = wd->n_shells;
   for (int ipar = 0; ipar <= 1; ipar++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sd_list* node1 = a2_list_i[ipar + 2*(imj + num_mj*(c + d*ns))];
+      size_t row1 = ipar + 2*(imj + num_mj*(c + d*ns));
       // Loop over final states resulting from 2x a_op
-      while (node1 != NULL) {
-        unsigned int ppf = node1->pn; // Get final state p_f
-        unsigned int ppi = node1->pi; // Get initial state p_i
-        int phase1 = node1->phase;
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a2_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppf = j1.pn; // Get final state p_f
+        unsigned int ppi = j1.pi; // Get initial state p_i
+        int phase1 = j1.phase;
         // Get list of n_i associated to p_i
-        sd_list* node2 = a2_list_f[ipar + 2*(num_mj - imj - 1 + num_mj*(a + b*ns))]; //hash corresponds to a_op operators
+        size_t row2 = ipar + 2*(num_mj - imj - 1 + num_mj*(a + b*ns)); //hash corresponds to a_op operators
         // Loop over n_f  
-        while (node2 != NULL) {
-          unsigned int pni = node2->pi;
-          unsigned int pnf = node2->pn;
-          int phase2 = node2->phase;
-          int index_i = -1;
-          int index_f = -1;
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a2_jumps_f, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          int phase2 = j2.phase;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
           if (i_op == 0) {
-            unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pni % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pni == node3->pn) && (ppi == node3->pp)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pnf % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pnf == node3->pn) && (ppf == node3->pp)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_i = basis_lookup(wd->basis_i, ppi, pni);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pnf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -1820,27 +2137,12 @@ void trace_a22_nodes(int a, int b, int c, int d, int num_mj, sd_list** a2_list_i
               eig_pair = eig_pair->next;
             }
            } else {
-            unsigned int p_hash_i = pni + wd->n_sds_p_i*(ppi % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pni == node3->pp) && (ppi == node3->pn)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = pnf + wd->n_sds_p_f*(ppf % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pnf == node3->pp) && (ppf == node3->pn)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_i = basis_lookup(wd->basis_i, pni, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pnf, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -1851,1000 +2153,1940 @@ void trace_a22_nodes(int a, int b, int c, int d, int num_mj, sd_list** a2_list_i
               eig_pair = eig_pair->next;
             }
           } 
-          node2 = node2->next;
         }
-        node1 = node1->next;
       }
     }  
   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void trace_a20_nodes(int a, int b, int c, int d, int num_mj, int n_sds_p_int1, int n_sds_n_int1, sd_list** p1_list_i, sd_list** n1_list_i, int* p1_array_f, int* n1_array_f, wfnData* wd, eigen_list* transition, double* density) {
-
-  int ns = wd->n_shells;
-  for (int ipar = 0; ipar <= 1; ipar++) {
-    for (int imj = 0; imj < num_mj; imj++) {
-      sd_list* node_pi = p1_list_i[ipar + 2*(imj + num_mj*b)]; // Get proton states resulting from p_b |p_i>
-      while (node_pi != NULL) {
-        int ppi = node_pi->pi; 
-        int ppn = node_pi->pn; // Get pn = p_a |p_i>
-        int phase1 = node_pi->phase;
-        int phase2 = 1;
-        int ppf = p1_array_f[(ppn - 1) + n_sds_p_int1*a]; // Get pf such that pn = p_a |p_f>
-        if (ppf == 0) {node_pi = node_pi->next; continue;}
-        if (ppf < 0) {
-          ppf *= -1;
-          phase2 = -1;
-        }
-        sd_list* node_ni = n1_list_i[ipar + 2*(num_mj - imj - 1 + num_mj*d)]; // Get neutron states resulting from n_d |n_i>
-        while (node_ni != NULL) {
-          int pni = node_ni->pi;
-          int pnn = node_ni->pn; // Get nn = n_d |n_i>
-          int phase3 = node_ni->phase;
-          int phase4 = 1;
-          int pnf = n1_array_f[(pnn - 1) + n_sds_n_int1*c];
-          if (pnf == 0) {node_ni = node_ni->next; continue;}
-          if (pnf < 0) {
-            pnf *= -1;
-            phase4 = -1;
-          }
-          unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pni % HASH_SIZE);
-          unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pnf % HASH_SIZE);
-          wh_list *node3 = wd->wh_hash_i[p_hash_i]; // hash corresponds to a_op operators
-   
-          int index_i = -1;
-          int index_f = -1;
-          while (node3 != NULL) {
-            if ((pni == node3->pn) && (ppi == node3->pp)) {
-              index_i = node3->index;
-              break;
-            }
-            node3 = node3->next;
-          }
-          if (index_i < 0) {node_ni = node_ni->next; continue;}
-          node3 = wd->wh_hash_f[p_hash_f];
-          while (node3 != NULL) {
-            if ((pnf == node3->pn) && (ppf == node3->pp)) {
-              index_f = node3->index;
-              break;
-            }
-            node3 = node3->next;
-          }
-          if (index_f < 0) {node_ni = node_ni->next; continue;}
-          eigen_list* eig_pair = transition;
-          int i_trans = 0;
-          while (eig_pair != NULL) {
-            int psi_i = eig_pair->eig_i;
-            int psi_f = eig_pair->eig_f;
-            density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2*phase3*phase4;
-            i_trans++;
-            eig_pair = eig_pair->next;
-          }
-          node_ni = node_ni->next;
-        }
-        node_pi = node_pi->next;
-      }
-    } 
-  } 
-  return;
-}
-
-void trace_a4_nodes_spec(int a, int b, int c, int d, int num_mj, int n_sds_int2, int* p2_array_f, sde_list** p2_list_i, wfe_list** n0_list_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+void trace_a4_nodes_compose(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p1_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+/* Same trace as trace_a4_nodes without the two-body lists
+   a(d) a(c) |p_i> is generated by acting a(d) on the intermediate SDs of the
+   one-body list of orbital c, which takes ns times less memory than storing it
+*/
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A4, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A4, a, b, c, d, i_op, 0);
+  }
   int ns = wd->n_shells;
+  int n_p = (i_op == 0) ? wd->n_proton_i : wd->n_neutron_i;
 
   for (int ipar = 0; ipar <= 1; ipar++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sde_list* node1 = p2_list_i[ipar + 2*(imj + num_mj*(c + d*ns))];
-      while (node1 != NULL) {
-        unsigned int ppn = node1->pn;
-        unsigned int ppi = node1->pi;
-        int phase1 = node1->phase;
-        int n_q_spec_p = node1->n_quanta;
-        int ppf = p2_array_f[(ppn - 1) + n_sds_int2*(a + ns*b)];
-        if (ppf == 0) {node1 = node1->next; continue;}
+      size_t row1 = ipar + 2*(imj + num_mj*c);
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, p1_jumps_i, row1); jump_cursor_next(&j1);) {
+        int phase1;
+        unsigned int ppn = a_op(ns, n_p - 1, j1.pn, d + 1, &phase1, 1);
+        unsigned int ppi = j1.pi;
+        phase1 *= j1.phase;
+        if (ppn == 0) {continue;}
+        int ppf = rev_map_get(p2_map_f, ppn, a + ns*b);
+        if (ppf == 0) {continue;}
         int phase2 = 1;
-        node1 = node1->next;
         if (ppf < 0) {
           ppf *= -1;
           phase2 = -1;
         }
-        wfe_list* node2 = n0_list_i[ipar + 2*(num_mj - imj - 1)];
-        while (node2 != NULL) {
-          int pn = node2->p;
-          int n_q_spec_n = node2->n_quanta;
-          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
-          int index_i = -1;
-          int index_f = -1;
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, n0_jumps_i, row2); jump_cursor_next(&j2);) {
+          int pn = j2.pi;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
 
           if (i_op == 0) {
-            unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pn % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pn == node3->pn) && (ppi == node3->pp)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pn % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pn == node3->pn) && (ppf == node3->pp)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_i = basis_lookup(wd->basis_i, ppi, pn);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pn);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
               int psi_i = eig_pair->eig_i;
               int psi_f = eig_pair->eig_f;
-              density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+	      density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
               i_trans++;
               eig_pair = eig_pair->next;
             }
+           } else {
+            index_i = basis_lookup(wd->basis_i, pn, ppi);
+            if (index_i < 0) {continue;}
 
-          } else {
-            unsigned int p_hash_i = pn + wd->n_sds_p_i*(ppi % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pn == node3->pp) && (ppi == node3->pn)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = pn + wd->n_sds_p_f*(ppf % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pn == node3->pp) && (ppf == node3->pn)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_f = basis_lookup(wd->basis_f, pn, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
               int psi_i = eig_pair->eig_i;
               int psi_f = eig_pair->eig_f;
-              density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+	      density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
               i_trans++;
               eig_pair = eig_pair->next;
             }
           } 
-          node2 = node2->next;
         } 
       }
     }
    }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void trace_a22_nodes_spec(int a, int b, int c, int d, int num_mj, sde_list** a2_list_i, sde_list** a2_list_f, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
-/* 
+jump_table* pair_jumps_get(pair_jumps* pairs, int a, int b, int num_mj, rev_map* b2_map_f, jump_table* b0_jumps_i, wfnData* wd, int i_op, int with_quanta) {
+/* Returns the n_f reached by a(a) a(b) from the n_i of each (parity, mj) sector,
+   the created species of trace_a22_nodes_compose. The table depends only on
+   (a, b, i_op) and is rebuilt only when they change
+
+  Input(s):
+    pair_jumps* pairs: the table of the previous call, freed if it no longer applies
+    rev_map* b2_map_f, jump_table* b0_jumps_i: reverse map and a0 table of the created species
 
+  Output(s):
+    jump_table* f_jumps: rows indexed as b0_jumps_i, NULL if the created species does
+                         not go from its initial SDs to final SDs with two more particles
 */
-  double total = 0.0;
+  if ((pairs->a == a) && (pairs->b == b) && (pairs->i_op == i_op)) {return pairs->f_jumps;}
+  jump_table_free(pairs->f_jumps);
+  pairs->a = a;
+  pairs->b = b;
+  pairs->i_op = i_op;
+  pairs->f_jumps = NULL;
+  if (b2_map_f->n_p_int != ((i_op == 0) ? wd->n_neutron_i : wd->n_proton_i)) {return NULL;}
   int ns = wd->n_shells;
-  for (int ipar = 0; ipar <=1; ipar++) {
-    for (int imj = 0; imj < num_mj; imj++) {
-      sde_list* node1 = a2_list_i[ipar + 2*(imj + num_mj*(c + d*ns))];
-      // Loop over final states resulting from 2x a_op
-      while (node1 != NULL) {
-        unsigned int ppf = node1->pn; // Get final state p_f
-        unsigned int ppi = node1->pi; // Get initial state p_i
-        int phase1 = node1->phase;
-        int n_q_spec_p = node1->n_quanta;
-        // Get list of n_i associated to p_i
-        sde_list* node2 = a2_list_f[ipar + 2*(num_mj - imj - 1 + num_mj*(a + b*ns))]; //hash corresponds to a_op operators
-        // Loop over n_f  
-        while (node2 != NULL) {
-          unsigned int pni = node2->pi;
-          unsigned int pnf = node2->pn;
-          int phase2 = node2->phase;
-          int n_q_spec_n = node2->n_quanta;
-          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
-          int index_i = -1;
-          int index_f = -1;
-          if (i_op == 0) {
-            unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pni % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pni == node3->pn) && (ppi == node3->pp)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pnf % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pnf == node3->pn) && (ppf == node3->pp)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+  jump_table *f_jumps = jump_table_create(2*num_mj, 1, with_quanta);
+  for (int pass = 0; pass < 2; pass++) {
+    for (size_t row = 0; row < f_jumps->n_rows; row++) {
+      jump_cursor j0;
+      for (jump_cursor_init(&j0, b0_jumps_i, row); jump_cursor_next(&j0);) {
+        int pnf = rev_map_get(b2_map_f, j0.pi, a + ns*b);
+        if (pnf != 0) {jump_table_add(f_jumps, row, j0.pi, abs(pnf), (pnf < 0) ? -1 : 1, j0.n_quanta);}
+      }
+    }
+    if (pass == 0) {jump_table_begin_fill(f_jumps);}
+  }
+  jump_table_finish(f_jumps);
+  pairs->f_jumps = f_jumps;
+
+  return f_jumps;
+}
+
+void pair_jumps_free(pair_jumps* pairs) {
+  jump_table_free(pairs->f_jumps);
+  pairs->f_jumps = NULL;
+  pairs->a = -1;
+  return;
+}
+
+void trace_a22_nodes_compose(int a, int b, int c, int d, int num_mj, jump_table* a1_jumps_i, jump_table* f_jumps, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+/* Same trace as trace_a22_nodes without the two-body lists
+   The annihilated species goes through a(d) acting on its one-body list of
+   orbital c, the created one from its initial SDs to the final SDs through the
+   table f_jumps of pair_jumps_get
+*/
+  if (f_jumps == NULL) {return;}
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A22, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A22, a, b, c, d, i_op, 0);
+  }
+  int ns = wd->n_shells;
+  int n_p = (i_op == 0) ? wd->n_proton_i : wd->n_neutron_i;
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar + 2*(imj + num_mj*c);
+      // Loop over final states resulting from 2x a_op
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a1_jumps_i, row1); jump_cursor_next(&j1);) {
+        int phase1;
+        unsigned int ppf = a_op(ns, n_p - 1, j1.pn, d + 1, &phase1, 1); // Get final state p_f
+        unsigned int ppi = j1.pi; // Get initial state p_i
+        phase1 *= j1.phase;
+        if (ppf == 0) {continue;}
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        // Loop over n_f
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, f_jumps, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          int phase2 = j2.phase;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+          if (i_op == 0) {
+            index_i = basis_lookup(wd->basis_i, ppi, pni);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pnf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
               int psi_i = eig_pair->eig_i;
               int psi_f = eig_pair->eig_f;
-	      density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+	      density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
               i_trans++;
               eig_pair = eig_pair->next;
             }
            } else {
-            unsigned int p_hash_i = pni + wd->n_sds_p_i*(ppi % HASH_SIZE);
-            wh_list* node3 = wd->wh_hash_i[p_hash_i];
-            while (node3 != NULL) {
-              if ((pni == node3->pp) && (ppi == node3->pn)) {
-                index_i = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_i < 0) {node2 = node2->next; continue;}
-
-            unsigned int p_hash_f = pnf + wd->n_sds_p_f*(ppf % HASH_SIZE);
-            node3 = wd->wh_hash_f[p_hash_f];
-            while (node3 != NULL) {
-              if ((pnf == node3->pp) && (ppf == node3->pn)) {
-                index_f = node3->index;
-                break;
-              }
-              node3 = node3->next;
-            }
-            if (index_f < 0) {node2 = node2->next; continue;}
+            index_i = basis_lookup(wd->basis_i, pni, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pnf, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
               int psi_i = eig_pair->eig_i;
               int psi_f = eig_pair->eig_f;
-	      density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+	      density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
               i_trans++;
               eig_pair = eig_pair->next;
             }
           } 
-          node2 = node2->next;
         }
-        node1 = node1->next;
       }
     }  
   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void trace_a20_nodes_spec(int a, int b, int c, int d, int num_mj, int n_sds_p_int1, int n_sds_n_int1, sde_list** p1_list_i, sde_list** n1_list_i, int* p1_array_f, int* n1_array_f, wfnData* wd, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+void trace_a20_nodes(int a, int b, int c, int d, int num_mj, jump_table* p1_jumps_i, jump_table* n1_jumps_i, rev_map* p1_map_f, rev_map* n1_map_f, wfnData* wd, eigen_list* transition, double* density) {
+  if (wd->join_a20) {
+    trace_a20_nodes_join(a, b, c, d, num_mj, p1_jumps_i, n1_jumps_i, p1_map_f, n1_map_f, wd, transition, density);
+    return;
+  }
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A20, a, b, c, d, 0);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A20, a, b, c, d, 0, 0);
+  }
 
   int ns = wd->n_shells;
   for (int ipar = 0; ipar <= 1; ipar++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sde_list* node_pi = p1_list_i[ipar + 2*(imj + num_mj*b)]; // Get proton states resulting from p_b |p_i>
-      while (node_pi != NULL) {
-        int ppi = node_pi->pi; 
-        int ppn = node_pi->pn; // Get pn = p_a |p_i>
-        int phase1 = node_pi->phase;
+      size_t row_pi = ipar + 2*(imj + num_mj*b); // Get proton states resulting from p_b |p_i>
+      jump_cursor j_pi;
+      for (jump_cursor_init(&j_pi, p1_jumps_i, row_pi); jump_cursor_next(&j_pi);) {
+        int ppi = j_pi.pi; 
+        int ppn = j_pi.pn; // Get pn = p_a |p_i>
+        int phase1 = j_pi.phase;
         int phase2 = 1;
-        int n_q_spec_p = node_pi->n_quanta;
-        int ppf = p1_array_f[(ppn - 1) + n_sds_p_int1*a]; // Get pf such that pn = p_a |p_f>
-        if (ppf == 0) {node_pi = node_pi->next; continue;}
+        int ppf = rev_map_get(p1_map_f, ppn, a); // Get pf such that pn = p_a |p_f>
+        if (ppf == 0) {continue;}
         if (ppf < 0) {
           ppf *= -1;
           phase2 = -1;
         }
-        sde_list* node_ni = n1_list_i[ipar + 2*(num_mj - imj - 1 + num_mj*d)]; // Get neutron states resulting from n_d |n_i>
-        while (node_ni != NULL) {
-          int pni = node_ni->pi;
-          int pnn = node_ni->pn; // Get nn = n_d |n_i>
-          int phase3 = node_ni->phase;
-          int n_q_spec_n = node_ni->n_quanta;
+        size_t row_ni = ipar + 2*(num_mj - imj - 1 + num_mj*d); // Get neutron states resulting from n_d |n_i>
+        jump_cursor j_ni;
+        for (jump_cursor_init(&j_ni, n1_jumps_i, row_ni); jump_cursor_next(&j_ni);) {
+          int pni = j_ni.pi;
+          int pnn = j_ni.pn; // Get nn = n_d |n_i>
+          int phase3 = j_ni.phase;
           int phase4 = 1;
-          int pnf = n1_array_f[(pnn - 1) + n_sds_n_int1*c];
-          if (pnf == 0) {node_ni = node_ni->next; continue;}
+          int pnf = rev_map_get(n1_map_f, pnn, c);
+          if (pnf == 0) {continue;}
           if (pnf < 0) {
             pnf *= -1;
             phase4 = -1;
           }
-          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
-          unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pni % HASH_SIZE);
-          unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pnf % HASH_SIZE);
-          wh_list *node3 = wd->wh_hash_i[p_hash_i]; // hash corresponds to a_op operators
    
-          int index_i = -1;
-          int index_f = -1;
-          while (node3 != NULL) {
-            if ((pni == node3->pn) && (ppi == node3->pp)) {
-              index_i = node3->index;
-              break;
-            }
-            node3 = node3->next;
-          }
-          if (index_i < 0) {node_ni = node_ni->next; continue;}
-          node3 = wd->wh_hash_f[p_hash_f];
-          while (node3 != NULL) {
-            if ((pnf == node3->pn) && (ppf == node3->pp)) {
-              index_f = node3->index;
-              break;
-            }
-            node3 = node3->next;
-          }
-          if (index_f < 0) {node_ni = node_ni->next; continue;}
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+          index_i = basis_lookup(wd->basis_i, ppi, pni);
+          if (index_i < 0) {continue;}
+          index_f = basis_lookup(wd->basis_f, ppf, pnf);
+          if (index_f < 0) {continue;}
+          if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2*phase3*phase4, 0)) {continue;}
           eigen_list* eig_pair = transition;
           int i_trans = 0;
           while (eig_pair != NULL) {
             int psi_i = eig_pair->eig_i;
             int psi_f = eig_pair->eig_f;
-	    density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+            density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2*phase3*phase4;
             i_trans++;
             eig_pair = eig_pair->next;
           }
-          node_ni = node_ni->next;
         }
-        node_pi = node_pi->next;
       }
     } 
   } 
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void build_two_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, int n_sds_int1, int n_sds_int2, int*a1_array_f, int* a2_array_f, wfe_list** a0_list_i, sde_list** a1_list_i, sde_list** a2_list_i, int* jz_shell, int* l_shell, int* n_shell) {
-/*
-  Input(s):
-    mj_min_i: 
+void trace_resolved_table(wfnData* wd, resolved_table* table, eigen_list* transition, double* density, int n_spec_bins) {
+/* Accumulates the density of every transition from a resolved jump table
+   In spectator mode each pair goes to its own bin, density[bin + n_spec_bins*i_trans]
 */
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj;
-    int parity, n_quanta;
-    get_m_pi_q(j, n_s, n_p, n_shell, l_shell, jz_shell, &mj, &parity, &n_quanta, j_min);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_parity = (parity + 1)/2;
-    int i_mj = mj - mj_min;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wfe_node(j, n_quanta, NULL);
-    } else {
-      wfe_append(a0_list_i[i_parity + 2*i_mj], j, n_quanta);
-    }
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      int n_spec1 = n_quanta - (2*n_shell[b] + l_shell[b]);
-      a1_array_f[(pn1 - 1) + b*n_sds_int1] = j*phase1;
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*b)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*b)] = create_sde_node(j, pn1, phase1, n_spec1, NULL);
-      } else {
-        sde_append(a1_list_i[i_parity + 2*(i_mj + num_mj*b)], j, pn1, phase1, n_spec1);
+  eigen_list* eig_pair = transition;
+  int i_trans = 0;
+  while (eig_pair != NULL) {
+    const float *bc_i = wd->bc_i + eig_pair->eig_i;
+    const float *bc_f = wd->bc_f + eig_pair->eig_f;
+    int n_eig_i = wd->n_eig_i;
+    int n_eig_f = wd->n_eig_f;
+    if (table->with_bins) {
+      double *density_trans = density + n_spec_bins*i_trans;
+      for (long long int k = 0; k < table->n; k++) {
+        density_trans[table->bin[k]] += bc_i[(long long int) n_eig_i*table->index_i[k]]*bc_f[(long long int) n_eig_f*table->index_f[k]]*table->phase[k];
       }
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        int n_spec2 = n_spec1 - (2*n_shell[a] + l_shell[a]);
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sde_node(j, pn2, phase1*phase2, n_spec2, NULL);
-        } else {
-          sde_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], j, pn2, phase1*phase2, n_spec2);
-        }
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sde_node(j, pn2, -phase1*phase2, n_spec2, NULL);
-        } else {
-          sde_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], j, pn2, -phase1*phase2, n_spec2);
-        }
-        a2_array_f[(pn2 - 1) + n_sds_int2*(b + a*n_s)] = phase1*phase2*j;
-        a2_array_f[(pn2 - 1) + n_sds_int2*(a + b*n_s)] = -phase1*phase2*j;
+    } else {
+      double total = 0.0;
+      for (long long int k = 0; k < table->n; k++) {
+        total += bc_i[(long long int) n_eig_i*table->index_i[k]]*bc_f[(long long int) n_eig_f*table->index_f[k]]*table->phase[k];
       }
+      density[i_trans] += total;
     }
-  } 
+    i_trans++;
+    eig_pair = eig_pair->next;
+  }
+  return;
+}
 
+void trace_join_sector(wfnData* wd, long long int n_query, wh_query* query_i, wh_query* query_f, int* phase, eigen_list* transition, double* density) {
+/* Resolves the initial and final basis states of a batch of jumps with merge-join
+   lookups and accumulates the density of every pair found in both bases
+*/
+  basis_int *index_i = (basis_int*) malloc(sizeof(basis_int)*n_query);
+  basis_int *index_f = (basis_int*) malloc(sizeof(basis_int)*n_query);
+  if ((index_i == NULL) || (index_f == NULL)) {printf("Error allocating join buffers\n"); exit(0);}
+  basis_lookup_sorted(wd->basis_i, n_query, query_i, index_i);
+  basis_lookup_sorted(wd->basis_f, n_query, query_f, index_f);
+  for (long long int q = 0; q < n_query; q++) {
+    if ((index_i[q] < 0) || (index_f[q] < 0)) {continue;}
+    eigen_list* eig_pair = transition;
+    int i_trans = 0;
+    while (eig_pair != NULL) {
+      int psi_i = eig_pair->eig_i;
+      int psi_f = eig_pair->eig_f;
+      density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i[q]]*wd->bc_f[psi_f + wd->n_eig_f*index_f[q]]*phase[q];
+      i_trans++;
+      eig_pair = eig_pair->next;
+    }
+  }
+  free(index_i);
+  free(index_f);
   return;
 }
 
-void build_two_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wfe_list** a0_list_i, sde_list** a1_list_i, sde_list** a2_list_i, int* jz_shell, int* l_shell, int* n_shell) {
-
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj;
-    int parity, n_quanta;
-    get_m_pi_q(j, n_s, n_p, n_shell, l_shell, jz_shell, &mj, &parity, &n_quanta, j_min);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_mj = mj - mj_min;
-    int i_parity = (parity + 1)/2;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wfe_node(j, n_quanta, NULL);
-    } else {
-      wfe_append(a0_list_i[i_parity + 2*i_mj], j, n_quanta);
+void trace_a22_nodes_join(int a, int b, int c, int d, int num_mj, jump_table* a2_jumps_i, jump_table* a2_jumps_f, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+/* Batched form of trace_a22_nodes: the basis states reached in each (parity, mj) sector
+   are collected first and resolved by sorting and merging with the sorted basis keys,
+   at most MERGE_JOIN_BATCH of them at a time
+*/
+  int ns = wd->n_shells;
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar + 2*(imj + num_mj*(c + d*ns));
+      size_t row2 = ipar + 2*(num_mj - imj - 1 + num_mj*(a + b*ns));
+      long long int n1 = a2_jumps_i->start[row1 + 1] - a2_jumps_i->start[row1];
+      long long int n2 = a2_jumps_f->start[row2 + 1] - a2_jumps_f->start[row2];
+      long long int n_query = n1*n2;
+      if (n_query == 0) {continue;}
+      long long int n_batch = MIN(n_query, MERGE_JOIN_BATCH);
+      wh_query *query_i = (wh_query*) malloc(sizeof(wh_query)*n_batch);
+      wh_query *query_f = (wh_query*) malloc(sizeof(wh_query)*n_batch);
+      int *phase = (int*) malloc(sizeof(int)*n_batch);
+      if ((query_i == NULL) || (query_f == NULL) || (phase == NULL)) {printf("Error allocating join buffers\n"); exit(0);}
+      long long int q = 0;
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a2_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppf = j1.pn;
+        unsigned int ppi = j1.pi;
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a2_jumps_f, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          if (i_op == 0) {
+            query_i[q].key = wh_key(ppi, pni);
+            query_f[q].key = wh_key(ppf, pnf);
+          } else {
+            query_i[q].key = wh_key(pni, ppi);
+            query_f[q].key = wh_key(pnf, ppf);
+          }
+          query_i[q].pos = q;
+          query_f[q].pos = q;
+          phase[q] = j1.phase*j2.phase;
+          q++;
+          if (q == n_batch) {
+            trace_join_sector(wd, q, query_i, query_f, phase, transition, density);
+            q = 0;
+          }
+        }
+      }
+      if (q > 0) {trace_join_sector(wd, q, query_i, query_f, phase, transition, density);}
+      free(query_i);
+      free(query_f);
+      free(phase);
     }
+  }
+  return;
+}
 
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      int n_spec1 = n_quanta - (2*n_shell[b] + l_shell[b]);
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*b)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*b)] = create_sde_node(j, pn1, phase1, n_spec1, NULL);
-      } else {
-        sde_append(a1_list_i[i_parity + 2*(i_mj + num_mj*b)], j, pn1, phase1, n_spec1);
+void trace_a20_nodes_join(int a, int b, int c, int d, int num_mj, jump_table* p1_jumps_i, jump_table* n1_jumps_i, rev_map* p1_map_f, rev_map* n1_map_f, wfnData* wd, eigen_list* transition, double* density) {
+/* Batched form of trace_a20_nodes, see trace_a22_nodes_join
+*/
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row_p = ipar + 2*(imj + num_mj*b);
+      size_t row_n = ipar + 2*(num_mj - imj - 1 + num_mj*d);
+      long long int n_p = 0, n_n = 0;
+      jump_cursor j;
+      for (jump_cursor_init(&j, p1_jumps_i, row_p); jump_cursor_next(&j);) {
+        if (rev_map_get(p1_map_f, j.pn, a) != 0) {n_p++;}
       }
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        int n_spec2 = n_spec1 - (2*n_shell[a] + l_shell[a]);
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sde_node(j, pn2, phase1*phase2, n_spec2, NULL);
-        } else {
-          sde_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], j, pn2, phase1*phase2, n_spec2);
+      for (jump_cursor_init(&j, n1_jumps_i, row_n); jump_cursor_next(&j);) {
+        if (rev_map_get(n1_map_f, j.pn, c) != 0) {n_n++;}
+      }
+      long long int n_query = n_p*n_n;
+      if (n_query == 0) {continue;}
+      long long int n_batch = MIN(n_query, MERGE_JOIN_BATCH);
+      wh_query *query_i = (wh_query*) malloc(sizeof(wh_query)*n_batch);
+      wh_query *query_f = (wh_query*) malloc(sizeof(wh_query)*n_batch);
+      int *phase = (int*) malloc(sizeof(int)*n_batch);
+      if ((query_i == NULL) || (query_f == NULL) || (phase == NULL)) {printf("Error allocating join buffers\n"); exit(0);}
+      long long int q = 0;
+      jump_cursor j_pi;
+      for (jump_cursor_init(&j_pi, p1_jumps_i, row_p); jump_cursor_next(&j_pi);) {
+        int ppf = rev_map_get(p1_map_f, j_pi.pn, a);
+        if (ppf == 0) {continue;}
+        int phase_p = j_pi.phase;
+        if (ppf < 0) {
+          ppf *= -1;
+          phase_p *= -1;
         }
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sde_node(j, pn2, -phase1*phase2, n_spec2, NULL);
-        } else {
-          sde_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], j, pn2, -phase1*phase2, n_spec2);
+        jump_cursor j_ni;
+        for (jump_cursor_init(&j_ni, n1_jumps_i, row_n); jump_cursor_next(&j_ni);) {
+          int pnf = rev_map_get(n1_map_f, j_ni.pn, c);
+          if (pnf == 0) {continue;}
+          int phase_n = j_ni.phase;
+          if (pnf < 0) {
+            pnf *= -1;
+            phase_n *= -1;
+          }
+          query_i[q].key = wh_key(j_pi.pi, j_ni.pi);
+          query_f[q].key = wh_key(ppf, pnf);
+          query_i[q].pos = q;
+          query_f[q].pos = q;
+          phase[q] = phase_p*phase_n;
+          q++;
+          if (q == n_batch) {
+            trace_join_sector(wd, q, query_i, query_f, phase, transition, density);
+            q = 0;
+          }
         }
       }
+      if (q > 0) {trace_join_sector(wd, q, query_i, query_f, phase, transition, density);}
+      free(query_i);
+      free(query_f);
+      free(phase);
     }
   }
+  return;
+}
 
+void trace_a4_nodes_spec(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p2_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A4_SPEC, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A4_SPEC, a, b, c, d, i_op, 1);
+  }
+  int ns = wd->n_shells;
+
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar + 2*(imj + num_mj*(c + d*ns));
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, p2_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppn = j1.pn;
+        unsigned int ppi = j1.pi;
+        int phase1 = j1.phase;
+        int n_q_spec_p = j1.n_quanta;
+        int ppf = rev_map_get(p2_map_f, ppn, a + ns*b);
+        if (ppf == 0) {continue;}
+        int phase2 = 1;
+        if (ppf < 0) {
+          ppf *= -1;
+          phase2 = -1;
+        }
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, n0_jumps_i, row2); jump_cursor_next(&j2);) {
+          int pn = j2.pi;
+          int n_q_spec_n = j2.n_quanta;
+          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+
+          if (i_op == 0) {
+            index_i = basis_lookup(wd->basis_i, ppi, pn);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pn);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+              density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+
+          } else {
+            index_i = basis_lookup(wd->basis_i, pn, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pn, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+              density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+          } 
+        } 
+      }
+    }
+   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void build_two_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, sde_list** a2_list_f, int* jz_shell, int* l_shell, int* n_shell) {
-  
-  for (int j = 1; j <= n_sds_f; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      a1_array_f[(pn1 - 1) + b*n_sds_int1] = j*phase1;
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        a2_array_f[(pn2 - 1) + n_sds_int2*(b + a*n_s)] = phase1*phase2*j;
-        a2_array_f[(pn2 - 1) + n_sds_int2*(a + b*n_s)] = -phase1*phase2*j;
-        float mj;
-        int parity, n_quanta;
-        get_m_pi_q(pn2, n_s, n_p - 2, n_shell, l_shell, jz_shell, &mj, &parity, &n_quanta, j_min);
-        if ((mj > mj_max) || (mj < mj_min)) {continue;}
-        int i_mj = mj - mj_min;
-        int i_parity = (parity + 1)/2;
-        if (a2_list_f[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_f[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sde_node(pn2, j, phase1*phase2, n_quanta, NULL);
-        } else {
-          sde_append(a2_list_f[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], pn2, j, phase1*phase2, n_quanta);
+void trace_a22_nodes_spec(int a, int b, int c, int d, int num_mj, jump_table* a2_jumps_i, jump_table* a2_jumps_f, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+/* 
+
+*/
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A22_SPEC, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A22_SPEC, a, b, c, d, i_op, 1);
+  }
+  double total = 0.0;
+  int ns = wd->n_shells;
+  for (int ipar = 0; ipar <=1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar + 2*(imj + num_mj*(c + d*ns));
+      // Loop over final states resulting from 2x a_op
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a2_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppf = j1.pn; // Get final state p_f
+        unsigned int ppi = j1.pi; // Get initial state p_i
+        int phase1 = j1.phase;
+        int n_q_spec_p = j1.n_quanta;
+        // Get list of n_i associated to p_i
+        size_t row2 = ipar + 2*(num_mj - imj - 1 + num_mj*(a + b*ns)); //hash corresponds to a_op operators
+        // Loop over n_f  
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a2_jumps_f, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          int phase2 = j2.phase;
+          int n_q_spec_n = j2.n_quanta;
+          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+          if (i_op == 0) {
+            index_i = basis_lookup(wd->basis_i, ppi, pni);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pnf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+	      density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+           } else {
+            index_i = basis_lookup(wd->basis_i, pni, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pnf, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+	      density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+          } 
         }
-        if (a2_list_f[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_f[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sde_node(pn2, j, -phase1*phase2, n_quanta, NULL);
-        } else {
-          sde_append(a2_list_f[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], pn2, j, -phase1*phase2, n_quanta);
+      }
+    }  
+  }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
+  }
+  return;
+}
+
+void trace_a4_nodes_spec_compose(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p1_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+  // trace_a4_nodes_compose with spectator bins
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A4_SPEC, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A4_SPEC, a, b, c, d, i_op, 1);
+  }
+  int ns = wd->n_shells;
+  int n_p = (i_op == 0) ? wd->n_proton_i : wd->n_neutron_i;
+
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar + 2*(imj + num_mj*c);
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, p1_jumps_i, row1); jump_cursor_next(&j1);) {
+        int phase1;
+        unsigned int ppn = a_op(ns, n_p - 1, j1.pn, d + 1, &phase1, 1);
+        unsigned int ppi = j1.pi;
+        phase1 *= j1.phase;
+        int n_q_spec_p = j1.n_quanta - (2*wd->n_shell[d] + wd->l_shell[d]);
+        if (ppn == 0) {continue;}
+        int ppf = rev_map_get(p2_map_f, ppn, a + ns*b);
+        if (ppf == 0) {continue;}
+        int phase2 = 1;
+        if (ppf < 0) {
+          ppf *= -1;
+          phase2 = -1;
         }
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, n0_jumps_i, row2); jump_cursor_next(&j2);) {
+          int pn = j2.pi;
+          int n_q_spec_n = j2.n_quanta;
+          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+
+          if (i_op == 0) {
+            index_i = basis_lookup(wd->basis_i, ppi, pn);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pn);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+              density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+
+          } else {
+            index_i = basis_lookup(wd->basis_i, pn, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pn, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+              density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+          } 
+        } 
       }
     }
+   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
   }
+  return;
+}
 
+void trace_a22_nodes_spec_compose(int a, int b, int c, int d, int num_mj, jump_table* a1_jumps_i, jump_table* f_jumps, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+  // trace_a22_nodes_compose with spectator bins
+  if (f_jumps == NULL) {return;}
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A22_SPEC, a, b, c, d, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A22_SPEC, a, b, c, d, i_op, 1);
+  }
+  int ns = wd->n_shells;
+  int n_p = (i_op == 0) ? wd->n_proton_i : wd->n_neutron_i;
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar + 2*(imj + num_mj*c);
+      // Loop over final states resulting from 2x a_op
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a1_jumps_i, row1); jump_cursor_next(&j1);) {
+        int phase1;
+        unsigned int ppf = a_op(ns, n_p - 1, j1.pn, d + 1, &phase1, 1); // Get final state p_f
+        unsigned int ppi = j1.pi; // Get initial state p_i
+        phase1 *= j1.phase;
+        int n_q_spec_p = j1.n_quanta - (2*wd->n_shell[d] + wd->l_shell[d]);
+        if (ppf == 0) {continue;}
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        // Loop over n_f
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, f_jumps, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          int phase2 = j2.phase;
+          int n_q_spec_n = j2.n_quanta;
+          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+          if (i_op == 0) {
+            index_i = basis_lookup(wd->basis_i, ppi, pni);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, ppf, pnf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+	      density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+           } else {
+            index_i = basis_lookup(wd->basis_i, pni, ppi);
+            if (index_i < 0) {continue;}
+
+            index_f = basis_lookup(wd->basis_f, pnf, ppf);
+            if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+            eigen_list* eig_pair = transition;
+            int i_trans = 0;
+            while (eig_pair != NULL) {
+              int psi_i = eig_pair->eig_i;
+              int psi_f = eig_pair->eig_f;
+	      density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+              i_trans++;
+              eig_pair = eig_pair->next;
+            }
+          } 
+        }
+      }
+    }  
+  }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void build_two_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, int n_sds_int1, int n_sds_int2, int*a1_array_f, int* a2_array_f, wf_list** a0_list_i, sd_list** a1_list_i, sd_list** a2_list_i, int* jz_shell, int* l_shell, int* w_shell, int w_max) {
-/*
+void trace_a20_nodes_spec(int a, int b, int c, int d, int num_mj, jump_table* p1_jumps_i, jump_table* n1_jumps_i, rev_map* p1_map_f, rev_map* n1_map_f, wfnData* wd, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_A20_SPEC, a, b, c, d, 0);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_A20_SPEC, a, b, c, d, 0, 1);
+  }
+
+  int ns = wd->n_shells;
+  for (int ipar = 0; ipar <= 1; ipar++) {
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row_pi = ipar + 2*(imj + num_mj*b); // Get proton states resulting from p_b |p_i>
+      jump_cursor j_pi;
+      for (jump_cursor_init(&j_pi, p1_jumps_i, row_pi); jump_cursor_next(&j_pi);) {
+        int ppi = j_pi.pi; 
+        int ppn = j_pi.pn; // Get pn = p_a |p_i>
+        int phase1 = j_pi.phase;
+        int phase2 = 1;
+        int n_q_spec_p = j_pi.n_quanta;
+        int ppf = rev_map_get(p1_map_f, ppn, a); // Get pf such that pn = p_a |p_f>
+        if (ppf == 0) {continue;}
+        if (ppf < 0) {
+          ppf *= -1;
+          phase2 = -1;
+        }
+        size_t row_ni = ipar + 2*(num_mj - imj - 1 + num_mj*d); // Get neutron states resulting from n_d |n_i>
+        jump_cursor j_ni;
+        for (jump_cursor_init(&j_ni, n1_jumps_i, row_ni); jump_cursor_next(&j_ni);) {
+          int pni = j_ni.pi;
+          int pnn = j_ni.pn; // Get nn = n_d |n_i>
+          int phase3 = j_ni.phase;
+          int n_q_spec_n = j_ni.n_quanta;
+          int phase4 = 1;
+          int pnf = rev_map_get(n1_map_f, pnn, c);
+          if (pnf == 0) {continue;}
+          if (pnf < 0) {
+            pnf *= -1;
+            phase4 = -1;
+          }
+          int i_spec = n_q_spec_p + n_q_spec_n - n_q_spec_min;
+   
+          basis_int index_i = -1;
+          basis_int index_f = -1;
+          index_i = basis_lookup(wd->basis_i, ppi, pni);
+          if (index_i < 0) {continue;}
+          index_f = basis_lookup(wd->basis_f, ppf, pnf);
+          if (index_f < 0) {continue;}
+          if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
+          eigen_list* eig_pair = transition;
+          int i_trans = 0;
+          while (eig_pair != NULL) {
+            int psi_i = eig_pair->eig_i;
+            int psi_f = eig_pair->eig_f;
+	    density[i_spec + n_spec_bins*i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase1*phase2;
+            i_trans++;
+            eig_pair = eig_pair->next;
+          }
+        }
+      }
+    } 
+  } 
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
+  }
+  return;
+}
+
+int jump_keys_match(const jump_key* x, const jump_key* y) {
+/* Checks if two jump builds give the same tables, so the second can share the first
+   The proton and neutron builds of N = Z nuclei match, unless the basis uses
+   different proton and neutron SDs
+*/
+  if ((x->n_s != y->n_s) || (x->n_p != y->n_p) || (x->num_mj != y->num_mj) || (x->w_max != y->w_max) || (x->n_sds != y->n_sds)) {return 0;}
+  if ((x->mj_min != y->mj_min) || (x->mj_max != y->mj_max)) {return 0;}
+  if (x->present == y->present) {return 1;}
+  if ((x->present == NULL) || (y->present == NULL)) {return 0;}
+
+  return (memcmp(x->present, y->present, (size_t) x->n_sds + 1) == 0);
+}
+
+static void jump_plan_share(jump_plan* plan) {
+  // Species sharing their tables build what either of them needs
+  if (plan->share_i) {
+    plan->jumps_i[0] = plan->jumps_i[1] = plan->jumps_i[0] | plan->jumps_i[1];
+    plan->hops_i[0] = plan->hops_i[1] = plan->hops_i[0] | plan->hops_i[1];
+  }
+  if (plan->share_f) {
+    plan->jumps_f[0] = plan->jumps_f[1] = plan->jumps_f[0] | plan->jumps_f[1];
+    plan->maps_f[0] = plan->maps_f[1] = plan->maps_f[0] | plan->maps_f[1];
+  }
+}
+
+jump_plan plan_two_body_jumps(float mt_op, int compose, int share_i, int share_f) {
+/* Plans the jumps of a two-body density run
+   The traces pair the operators with mt1 + mt2 - mt3 - mt4 = mt_op, so an operator
+   conserving Tz reaches the a4 (pp -> pp, nn -> nn) and a20 (pn -> pn) kernels, and
+   one changing Tz by two only reaches the a22 kernel, annihilating two neutrons for
+   mt_op = +2 and two protons for mt_op = -2. No kernel changes Tz by one. Parity is
+   checked per orbital quadruple and every run keeps some quadruples of each kernel
+
   Input(s):
-    mj_min_i: 
+    float mt_op: Tz of the final nucleus minus Tz of the initial one
+    int compose: 1 if the a4/a22 traces compose the one-body tables (TWO_BODY_COMPOSE)
+    int share_i, share_f: 1 if the neutrons use the proton initial tables (final maps and tables)
+
+  Output(s):
+    jump_plan: kernels reached and the tables and maps they read
 */
-  for (int j = 1; j <= n_sds_i; j++) {
-    if (w_from_p(j, n_s, n_p, w_shell) > w_max) {continue;}
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    int i_mj = mj - mj_min;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
+  jump_plan plan;
+  memset(&plan, 0, sizeof(jump_plan));
+  plan.share_i = share_i;
+  plan.share_f = share_f;
+  if (mt_op == 0) {
+    plan.kernels = KERNEL_A4 | KERNEL_A20;
+    for (int s = 0; s < 2; s++) {
+      // a4 of species s, over the a0 spectators of the other species
+      plan.jumps_i[s] |= (compose) ? PLAN_A(1) : PLAN_A(2);
+      plan.maps_f[s] |= PLAN_A(2);
+      plan.jumps_i[1 - s] |= PLAN_A(0);
+      // a20, one particle of each species
+      plan.jumps_i[s] |= PLAN_A(1);
+      plan.maps_f[s] |= PLAN_A(1);
+    }
+  } else if (fabs(mt_op) == 2) {
+    plan.kernels = KERNEL_A22;
+    int a = (mt_op > 0); // species annihilated
+    int c = 1 - a; // species created
+    if (compose) {
+      plan.jumps_i[a] |= PLAN_A(1);
+      plan.maps_f[c] |= PLAN_A(2);
+      plan.jumps_i[c] |= PLAN_A(0);
     } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
-    }
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      a1_array_f[(pn1 - 1) + b*n_sds_int1] = j*phase1;
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*b)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*b)] = create_sd_node(j, pn1, phase1, NULL);
+      plan.jumps_i[a] |= PLAN_A(2);
+      plan.jumps_f[c] |= PLAN_A(2);
+    }
+  }
+  jump_plan_share(&plan);
+
+  return plan;
+}
+
+jump_plan plan_one_body_jumps(float mt_op, int one_hop, int share_i, int share_f) {
+/* Plans the jumps of a one-body density run
+   The isospin coupling of a+(a) a(b) vanishes unless mt_a - mt_b = mt_op, so an
+   operator conserving Tz only reaches the t0 kernel and one changing Tz by one only
+   reaches the t2 kernel, annihilating a neutron for mt_op = +1 and a proton for
+   mt_op = -1
+
+  Input(s):
+    float mt_op: Tz of the final nucleus minus Tz of the initial one
+    int one_hop: 1 if t0 traces the a+a hop tables (ONE_BODY_HOPS)
+    int share_i, share_f: 1 if the neutrons use the proton initial tables (final maps and tables)
+
+  Output(s):
+    jump_plan: kernels reached and the tables and maps they read
+*/
+  jump_plan plan;
+  memset(&plan, 0, sizeof(jump_plan));
+  plan.share_i = share_i;
+  plan.share_f = share_f;
+  if (mt_op == 0) {
+    plan.kernels = KERNEL_T0;
+    for (int s = 0; s < 2; s++) {
+      if (one_hop) {
+        plan.hops_i[s] = 1;
       } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*b)], j, pn1, phase1);
+        plan.jumps_i[s] |= PLAN_A(1);
+        plan.maps_f[s] |= PLAN_A(1);
       }
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sd_node(j, pn2, phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], j, pn2, phase1*phase2);
+      plan.jumps_i[1 - s] |= PLAN_A(0);
+    }
+  } else if (fabs(mt_op) == 1) {
+    plan.kernels = KERNEL_T2;
+    int a = (mt_op > 0); // species annihilated
+    plan.jumps_i[a] |= PLAN_A(1);
+    plan.jumps_f[1 - a] |= PLAN_A(1);
+  }
+  jump_plan_share(&plan);
+
+  return plan;
+}
+
+void log_jump_plan(const jump_plan* plan, wfnData* wd, int num_mj, int with_quanta) {
+/* Prints the kernels of a plan and the memory each table and map it builds is estimated to take
+   An a_r table is counted with one entry for each ordered choice of r particles of
+   each SD and a map at its dense size, bounds that the mj window and the pruning
+   of the SDs only lower
+*/
+  const char *kernel_name[5] = {"a4", "a22", "a20", "t0", "t2"};
+  const char *species_name[2] = {"Proton", "Neutron"};
+  int ns = wd->n_shells;
+  int n_p[2][2] = {{wd->n_proton_i, wd->n_proton_f}, {wd->n_neutron_i, wd->n_neutron_f}};
+  double n_sds[2][2] = {{wd->n_sds_p_i, wd->n_sds_p_f}, {wd->n_sds_n_i, wd->n_sds_n_f}};
+  printf("Jump plan, kernels:");
+  for (int k = 0; k < 5; k++) {
+    if (plan->kernels & (1 << k)) {printf(" %s", kernel_name[k]);}
+  }
+  printf("%s\n", (plan->kernels == 0) ? " none" : "");
+  double total = 0.0;
+  for (int s = 0; s < 2; s++) {
+    for (int f = 0; f < 2; f++) {
+      printf("  %s %s:", species_name[s], (f) ? "final" : "initial");
+      if ((s == 1) && ((f) ? plan->share_f : plan->share_i)) {printf(" same as the protons\n"); continue;}
+      int jumps = (f) ? plan->jumps_f[s] : plan->jumps_i[s];
+      int maps = (f) ? plan->maps_f[s] : 0;
+      int n_built = 0;
+      for (int r = 0; r <= 2; r++) {
+        // Ordered choices of r of the particles
+        double n_choices = 1.0;
+        for (int k = 0; k < r; k++) {n_choices *= MAX(n_p[s][f] - k, 0);}
+        if (jumps & PLAN_A(r)) {
+          double mb = jump_table_estimate(2*num_mj*(size_t) pow(ns, r), n_sds[s][f]*n_choices, r > 0, with_quanta)/(1024*1024);
+          printf("%s a%d jumps %g MB", (n_built++) ? "," : "", r, mb);
+          total += mb;
         }
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sd_node(j, pn2, -phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], j, pn2, -phase1*phase2);
+        if (maps & PLAN_A(r)) {
+          double mb = rev_map_estimate(ns, n_p[s][f] - r, r)/(1024*1024);
+          printf("%s a%d map %g MB", (n_built++) ? "," : "", r, mb);
+          total += mb;
         }
-        a2_array_f[(pn2 - 1) + n_sds_int2*(b + a*n_s)] = phase1*phase2*j;
-        a2_array_f[(pn2 - 1) + n_sds_int2*(a + b*n_s)] = -phase1*phase2*j;
       }
+      if ((f == 0) && plan->hops_i[s]) {
+        double mb = jump_table_estimate(2*num_mj*(size_t) ns*ns, n_sds[s][f]*n_p[s][f]*ns, 1, with_quanta)/(1024*1024);
+        printf("%s a+a hops %g MB", (n_built++) ? "," : "", mb);
+        total += mb;
+      }
+      printf("%s\n", (n_built == 0) ? " nothing built" : "");
     }
-  } 
+  }
+  printf("Estimated jump memory: %g MB\n", total);
 
   return;
 }
 
+jump_table* jump_table_planned(arena* pool, int planned, size_t n_rows, int with_pn, int with_quanta) {
+  // Creates a table in pool if the plan builds it, NULL otherwise
+  if (!planned) {return NULL;}
+  return jump_table_create_in(pool, n_rows, with_pn, with_quanta);
+}
+
+rev_map* rev_map_planned(int planned, int n_s, int n_p_int, int n_created, int mode) {
+  // Creates a reverse map if the plan builds it, NULL otherwise
+  if (!planned) {return NULL;}
+  return rev_map_create(n_s, n_p_int, n_created, mode);
+}
 
-void build_two_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, int n_sds_int1, int n_sds_int2, int*a1_array_f, int* a2_array_f, wf_list** a0_list_i, sd_list** a1_list_i, sd_list** a2_list_i, int* jz_shell, int* l_shell) {
+void build_two_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present) {
 /*
   Input(s):
     mj_min_i: 
 */
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    int i_mj = mj - mj_min;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
-    } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
-    }
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      a1_array_f[(pn1 - 1) + b*n_sds_int1] = j*phase1;
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*b)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*b)] = create_sd_node(j, pn1, phase1, NULL);
-      } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*b)], j, pn1, phase1);
-      }
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sd_node(j, pn2, phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], j, pn2, phase1*phase2);
+  jump_split split;
+  jump_split_start(&split, n_sds_i, rev_map_parallel(a1_map_f) && rev_map_parallel(a2_map_f), a0_jumps_i, a1_jumps_i, a2_jumps_i);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      jump_table *a2_chunk = jump_split_view(&split, 2, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, n_shell, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        int parity = sd.parity;
+        int n_quanta = sd.n_quanta;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_parity = (parity + 1)/2;
+        int i_mj = mj - mj_min;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, n_quanta);
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          int n_spec1 = n_quanta - (2*n_shell[b] + l_shell[b]);
+          if (pass == 1) {rev_map_set(a1_map_f, pn1, b, j*phase1);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*b), j, pn1, phase1, n_spec1);
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            if (pass == 1) {
+              rev_map_set(a2_map_f, pn2, b + a*n_s, phase1*phase2*j);
+              rev_map_set(a2_map_f, pn2, a + b*n_s, -phase1*phase2*j);
+            }
+            if (a2_chunk == NULL) {continue;}
+            int n_spec2 = n_spec1 - (2*n_shell[a] + l_shell[a]);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), j, pn2, phase1*phase2, n_spec2);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), j, pn2, -phase1*phase2, n_spec2);
+          }
         }
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sd_node(j, pn2, -phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], j, pn2, -phase1*phase2);
+      } 
+      sd_walk_free(&walk);
+    }
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
+
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
+  rev_map_finish(a2_map_f);
+  return;
+}
+
+void build_two_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present) {
+
+  jump_split split;
+  jump_split_start(&split, n_sds_i, 1, a0_jumps_i, a1_jumps_i, a2_jumps_i);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      jump_table *a2_chunk = jump_split_view(&split, 2, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, n_shell, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        int parity = sd.parity;
+        int n_quanta = sd.n_quanta;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (parity + 1)/2;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, n_quanta);
+
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          int n_spec1 = n_quanta - (2*n_shell[b] + l_shell[b]);
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*b), j, pn1, phase1, n_spec1);
+          if (a2_chunk == NULL) {continue;}
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            int n_spec2 = n_spec1 - (2*n_shell[a] + l_shell[a]);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), j, pn2, phase1*phase2, n_spec2);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), j, pn2, -phase1*phase2, n_spec2);
+          }
         }
-        a2_array_f[(pn2 - 1) + n_sds_int2*(b + a*n_s)] = phase1*phase2*j;
-        a2_array_f[(pn2 - 1) + n_sds_int2*(a + b*n_s)] = -phase1*phase2*j;
       }
+      sd_walk_free(&walk);
     }
-  } 
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
+  jump_split_finish(&split);
   return;
 }
 
-void build_two_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wf_list** a0_list_i, sd_list** a1_list_i, sd_list** a2_list_i, int* jz_shell, int* l_shell) {
+void build_two_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a2_jumps_f, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present) {
+  
+  jump_split split;
+  jump_split_start(&split, n_sds_f, rev_map_parallel(a1_map_f) && rev_map_parallel(a2_map_f), a2_jumps_f, NULL, NULL);
+  for (int pass = (a2_jumps_f == NULL); pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a2_chunk = jump_split_view(&split, 0, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, NULL, NULL, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+    
+        if ((present != NULL) && !present[j]) {continue;}
+        int j_min = walk.sd.j_min;
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn1, b, j*phase1);}
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            if (pass == 1) {
+              rev_map_set(a2_map_f, pn2, b + a*n_s, phase1*phase2*j);
+              rev_map_set(a2_map_f, pn2, a + b*n_s, -phase1*phase2*j);
+            }
+            if (a2_chunk == NULL) {continue;}
+            sd_info sd;
+            decode_sd(pn2, n_s, n_p - 2, n_shell, l_shell, jz_shell, NULL, NULL, &sd);
+            float mj = sd.mj;
+            int parity = sd.parity;
+            int n_quanta = sd.n_quanta;
+            if ((mj > mj_max) || (mj < mj_min)) {continue;}
+            int i_mj = mj - mj_min;
+            int i_parity = (parity + 1)/2;
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), pn2, j, phase1*phase2, n_quanta);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), pn2, j, -phase1*phase2, n_quanta);
+          }
+        }
+      }
+      sd_walk_free(&walk);
+    }
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_mj = mj - mj_min;
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
-    } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
+  rev_map_finish(a2_map_f);
+  return;
+}
+
+void build_two_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present) {
+/*
+  Input(s):
+    mj_min_i: 
+*/
+  jump_split split;
+  jump_split_start(&split, n_sds_i, rev_map_parallel(a1_map_f) && rev_map_parallel(a2_map_f), a0_jumps_i, a1_jumps_i, a2_jumps_i);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      jump_table *a2_chunk = jump_split_view(&split, 2, c);
+      sd_walk walk;
+      // Only the SDs within the truncation are generated
+      sd_walk_start_trunc(&walk, n_s, n_p, NULL, l_shell, jz_shell, w_shell, w_max);
+      for (sd_walk_seek(&walk, split.first[c]); (walk.p != 0) && (walk.p < split.first[c + 1]); sd_walk_next(&walk)) {
+        int j = walk.p;
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_parity = (sd.parity + 1)/2;
+        int i_mj = mj - mj_min;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn1, b, j*phase1);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*b), j, pn1, phase1, 0);
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            if (pass == 1) {
+              rev_map_set(a2_map_f, pn2, b + a*n_s, phase1*phase2*j);
+              rev_map_set(a2_map_f, pn2, a + b*n_s, -phase1*phase2*j);
+            }
+            if (a2_chunk == NULL) {continue;}
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), j, pn2, phase1*phase2, 0);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), j, pn2, -phase1*phase2, 0);
+          }
+        }
+      } 
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*b)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*b)] = create_sd_node(j, pn1, phase1, NULL);
-      } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*b)], j, pn1, phase1);
-      }
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sd_node(j, pn2, phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], j, pn2, phase1*phase2);
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
+  rev_map_finish(a2_map_f);
+  return;
+}
+
+
+void build_two_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, unsigned char* present) {
+/*
+  Input(s):
+    mj_min_i: 
+*/
+  jump_split split;
+  jump_split_start(&split, n_sds_i, rev_map_parallel(a1_map_f) && rev_map_parallel(a2_map_f), a0_jumps_i, a1_jumps_i, a2_jumps_i);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      jump_table *a2_chunk = jump_split_view(&split, 2, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_parity = (sd.parity + 1)/2;
+        int i_mj = mj - mj_min;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn1, b, j*phase1);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*b), j, pn1, phase1, 0);
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            if (pass == 1) {
+              rev_map_set(a2_map_f, pn2, b + a*n_s, phase1*phase2*j);
+              rev_map_set(a2_map_f, pn2, a + b*n_s, -phase1*phase2*j);
+            }
+            if (a2_chunk == NULL) {continue;}
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), j, pn2, phase1*phase2, 0);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), j, pn2, -phase1*phase2, 0);
+          }
         }
-        if (a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sd_node(j, pn2, -phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_i[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], j, pn2, -phase1*phase2);
+      } 
+      sd_walk_free(&walk);
+    }
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
+
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
+  rev_map_finish(a2_map_f);
+  return;
+}
+
+void build_two_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, unsigned char* present) {
+
+  jump_split split;
+  jump_split_start(&split, n_sds_i, 1, a0_jumps_i, a1_jumps_i, a2_jumps_i);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      jump_table *a2_chunk = jump_split_view(&split, 2, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (sd.parity + 1)/2;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*b), j, pn1, phase1, 0);
+          if (a2_chunk == NULL) {continue;}
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), j, pn2, phase1*phase2, 0);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), j, pn2, -phase1*phase2, 0);
+          }
         }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
   return;
 }
 
-void build_two_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, sd_list** a2_list_f, int* jz_shell, int* l_shell) {
+void build_two_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a2_jumps_f, int* jz_shell, int* l_shell, unsigned char* present) {
   
-  for (int j = 1; j <= n_sds_f; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    for (int b = j_min - 1; b < n_s; b++) {
-      int phase1;
-      int pn1 = a_op(n_s, n_p, j, b + 1, &phase1, j_min);
-      if (pn1 == 0) {continue;}
-      a1_array_f[(pn1 - 1) + b*n_sds_int1] = j*phase1;
-      for (int a = j_min - 1; a < b; a++) {
-        int phase2;
-        int pn2 = a_op(n_s, n_p - 1, pn1, a + 1, &phase2, j_min);
-        if (pn2 == 0) {continue;}
-        a2_array_f[(pn2 - 1) + n_sds_int2*(b + a*n_s)] = phase1*phase2*j;
-        a2_array_f[(pn2 - 1) + n_sds_int2*(a + b*n_s)] = -phase1*phase2*j;
-        float mj = m_from_p(pn2, n_s, n_p - 2, jz_shell);
-        if ((mj > mj_max) || (mj < mj_min)) {continue;}
-        int i_mj = mj - mj_min;
-        int i_parity = (parity_from_p(pn2, n_s, n_p - 2, l_shell) + 1)/2;
-        if (a2_list_f[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] == NULL) {
-          a2_list_f[i_parity + 2*(i_mj + num_mj*(b + a*n_s))] = create_sd_node(pn2, j, phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_f[i_parity + 2*(i_mj + num_mj*(b + a*n_s))], pn2, j, phase1*phase2);
-        }
-        if (a2_list_f[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] == NULL) {
-          a2_list_f[i_parity + 2*(i_mj + num_mj*(a + b*n_s))] = create_sd_node(pn2, j, -phase1*phase2, NULL);
-        } else {
-          sd_append(a2_list_f[i_parity + 2*(i_mj + num_mj*(a + b*n_s))], pn2, j, -phase1*phase2);
+  jump_split split;
+  jump_split_start(&split, n_sds_f, rev_map_parallel(a1_map_f) && rev_map_parallel(a2_map_f), a2_jumps_f, NULL, NULL);
+  for (int pass = (a2_jumps_f == NULL); pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a2_chunk = jump_split_view(&split, 0, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, NULL, NULL, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+    
+        if ((present != NULL) && !present[j]) {continue;}
+        int j_min = walk.sd.j_min;
+        for (int b = j_min - 1; b < n_s; b++) {
+          int phase1;
+          sd_bits mask1;
+          int pn1 = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, b + 1, &phase1, j_min, &mask1);
+          if (pn1 == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn1, b, j*phase1);}
+          for (int a = j_min - 1; a < b; a++) {
+            int phase2;
+            sd_bits mask2;
+            int pn2 = sd_annihilate(n_s, n_p - 1, pn1, &mask1, walk.n_words, a + 1, &phase2, j_min, &mask2);
+            if (pn2 == 0) {continue;}
+            if (pass == 1) {
+              rev_map_set(a2_map_f, pn2, b + a*n_s, phase1*phase2*j);
+              rev_map_set(a2_map_f, pn2, a + b*n_s, -phase1*phase2*j);
+            }
+            if (a2_chunk == NULL) {continue;}
+            sd_info sd;
+            decode_sd(pn2, n_s, n_p - 2, NULL, l_shell, jz_shell, NULL, NULL, &sd);
+            float mj = sd.mj;
+            if ((mj > mj_max) || (mj < mj_min)) {continue;}
+            int i_mj = mj - mj_min;
+            int i_parity = (sd.parity + 1)/2;
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), pn2, j, phase1*phase2, 0);
+            jump_table_add(a2_chunk, i_parity + 2*(i_mj + num_mj*(a + b*n_s)), pn2, j, -phase1*phase2, 0);
+          }
         }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
+  rev_map_finish(a2_map_f);
   return;
 }
 
-void build_one_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, int n_sds_int, int*a1_array_f, wfe_list** a0_list_i, sde_list** a1_list_i, int* jz_shell, int* l_shell, int* n_shell) {
+void build_one_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, rev_map* a1_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present) {
 /*
   Input(s):
     mj_min_i: 
 */
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    int n_quanta, parity;
-    float mj;
-    get_m_pi_q(j, n_s, n_p, n_shell, l_shell, jz_shell, &mj, &parity, &n_quanta, j_min);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_parity = (parity + 1)/2;
-    int i_mj = mj - mj_min;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wfe_node(j, n_quanta, NULL);
-    } else {
-      wfe_append(a0_list_i[i_parity + 2*i_mj], j, n_quanta);
-    }
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      int n_spec1 = n_quanta - (2*n_shell[a] + l_shell[a]);
-      a1_array_f[(pn - 1) + a*n_sds_int] = j*phase;
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*a)] = create_sde_node(j, pn, phase, n_spec1, NULL);
-      } else {
-        sde_append(a1_list_i[i_parity + 2*(i_mj + num_mj*a)], j, pn, phase, n_spec1);
-      }
+  jump_split split;
+  jump_split_start(&split, n_sds_i, rev_map_parallel(a1_map_f), a0_jumps_i, a1_jumps_i, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, n_shell, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        int parity = sd.parity;
+        int n_quanta = sd.n_quanta;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_parity = (parity + 1)/2;
+        int i_mj = mj - mj_min;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, n_quanta);
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          int n_spec1 = n_quanta - (2*n_shell[a] + l_shell[a]);
+          if (pass == 1) {rev_map_set(a1_map_f, pn, a, j*phase);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), j, pn, phase, n_spec1);
+        }
+      } 
+      sd_walk_free(&walk);
     }
-  } 
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
   return;
 }
 
-void build_one_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wfe_list** a0_list_i, sde_list** a1_list_i,  int* jz_shell, int* l_shell, int* n_shell) {
-
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj;
-    int parity, n_quanta;
-    get_m_pi_q(j, n_s, n_p, n_shell, l_shell, jz_shell, &mj, &parity, &n_quanta, j_min);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_mj = mj - mj_min;
-    int i_parity = (parity + 1)/2;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wfe_node(j, n_quanta, NULL);
-    } else {
-      wfe_append(a0_list_i[i_parity + 2*i_mj], j, n_quanta);
-    }
-
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      int n_spec1 = n_quanta - (2*n_shell[a] + l_shell[a]);
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*a)] = create_sde_node(j, pn, phase, n_spec1, NULL);
-      } else {
-        sde_append(a1_list_i[i_parity + 2*(i_mj + num_mj*a)], j, pn, phase, n_spec1);
+void build_one_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i,  int* jz_shell, int* l_shell, int* n_shell, unsigned char* present) {
+
+  jump_split split;
+  jump_split_start(&split, n_sds_i, 1, a0_jumps_i, a1_jumps_i, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, n_shell, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        int parity = sd.parity;
+        int n_quanta = sd.n_quanta;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (parity + 1)/2;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, n_quanta);
+
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          int n_spec1 = n_quanta - (2*n_shell[a] + l_shell[a]);
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), j, pn, phase, n_spec1);
+        }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
   return;
 }
 
-void build_one_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, sde_list** a1_list_f, int* jz_shell, int* l_shell, int* n_shell) {
+void build_one_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a1_jumps_f, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present) {
   
-  for (int j = 1; j <= n_sds_f; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      a1_array_f[(pn - 1) + a*n_sds_int] = j*phase;
-      float mj;
-      int parity, n_quanta;
-      get_m_pi_q(j, n_s, n_p, n_shell, l_shell, jz_shell, &mj, &parity, &n_quanta, j_min);
-      if ((mj > mj_max) || (mj < mj_min)) {continue;}
-      int i_mj = mj - mj_min;
-      int i_parity = (parity + 1)/2;
-      if (a1_list_f[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_f[i_parity + 2*(i_mj + num_mj*a)] = create_sde_node(pn, j, phase, n_quanta, NULL);
-      } else {
-        sde_append(a1_list_f[i_parity + 2*(i_mj + num_mj*a)], pn, j, phase, n_quanta);
+  jump_split split;
+  jump_split_start(&split, n_sds_f, rev_map_parallel(a1_map_f), a1_jumps_f, NULL, NULL);
+  for (int pass = (a1_jumps_f == NULL); pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a1_chunk = jump_split_view(&split, 0, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, n_shell, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+    
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        int parity = sd.parity;
+        int n_quanta = sd.n_quanta;
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn, a, j*phase);}
+          if ((mj > mj_max) || (mj < mj_min)) {continue;}
+          int i_mj = mj - mj_min;
+          int i_parity = (parity + 1)/2;
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), pn, j, phase, n_quanta);
+        }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
   return;
 }
 
 
-void build_one_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, int n_sds_int, int*a1_array_f, wf_list** a0_list_i, sd_list** a1_list_i, int* jz_shell, int* l_shell, int* w_shell, int w_max) {
+void build_one_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, rev_map* a1_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present) {
 /*
   Input(s):
     mj_min_i: 
+    a1_map_f: may be NULL if only the initial state lists are needed
 */
-  for (int j = 1; j <= n_sds_i; j++) {
-    if (w_from_p(j, n_s, n_p, w_shell) > w_max) {continue;}
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    int i_mj = mj - mj_min;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
-    } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
-    }
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      a1_array_f[(pn - 1) + a*n_sds_int] = j*phase;
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*a)] = create_sd_node(j, pn, phase, NULL);
-      } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*a)], j, pn, phase);
-      }
+  jump_split split;
+  jump_split_start(&split, n_sds_i, rev_map_parallel(a1_map_f), a0_jumps_i, a1_jumps_i, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      sd_walk walk;
+      // Only the SDs within the truncation are generated
+      sd_walk_start_trunc(&walk, n_s, n_p, NULL, l_shell, jz_shell, w_shell, w_max);
+      for (sd_walk_seek(&walk, split.first[c]); (walk.p != 0) && (walk.p < split.first[c + 1]); sd_walk_next(&walk)) {
+        int j = walk.p;
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_parity = (sd.parity + 1)/2;
+        int i_mj = mj - mj_min;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          if ((pass == 1) && (a1_map_f != NULL)) {rev_map_set(a1_map_f, pn, a, j*phase);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), j, pn, phase, 0);
+        }
+      } 
+      sd_walk_free(&walk);
     }
-  } 
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
   return;
 }
 
 
-void build_one_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, int n_sds_int, int*a1_array_f, wf_list** a0_list_i, sd_list** a1_list_i, int* jz_shell, int* l_shell) {
+void build_one_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, rev_map* a1_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, unsigned char* present) {
 /*
   Input(s):
     mj_min_i: 
 */
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    int i_mj = mj - mj_min;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
-    } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
-    }
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      a1_array_f[(pn - 1) + a*n_sds_int] = j*phase;
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*a)] = create_sd_node(j, pn, phase, NULL);
-      } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*a)], j, pn, phase);
-      }
+  jump_split split;
+  jump_split_start(&split, n_sds_i, rev_map_parallel(a1_map_f), a0_jumps_i, a1_jumps_i, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_parity = (sd.parity + 1)/2;
+        int i_mj = mj - mj_min;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn, a, j*phase);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), j, pn, phase, 0);
+        }
+      } 
+      sd_walk_free(&walk);
     }
-  } 
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
   return;
 }
 
-void build_one_body_jumps_i_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wf_list** a0_list_i, sd_list** a1_list_i,  int* jz_shell, int* l_shell, int* w_shell, int w_max) {
-
-  for (int j = 1; j <= n_sds_i; j++) {
-    if (w_from_p(j, n_s, n_p, w_shell) > w_max) {continue;}
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_mj = mj - mj_min;
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
-    } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
+void build_one_body_hops_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a11_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present) {
+/* Builds the tables of a+(a) a(b) jumps between SDs of the same basis
+   Each entry holds the initial SD, the final SD and the phase of the pair of
+   operators, listed by the (parity, mj) sector of the initial SD. Only the pairs
+   of orbitals with the same jz and parity are listed, the ones the M = 0 one-body
+   densities trace, so the final SD stays in the sector of the initial one. The final
+   SDs pass the same filters (present, w_max) as the initial ones, so the jumps are
+   those the two-step lists and a1_map_f give without the intermediate SD.
+   Requires the orbitals to fit in an occupation mask
+
+  Input(s):
+    int n_s: number of single-particle states
+    int n_p: number of particles
+    float mj_min, mj_max: range of mj of the SDs
+    int num_mj: number of mj sectors
+    int n_sds_i: number of SDs
+    int arrays jz_shell, l_shell, w_shell: shell quantum numbers of each orbital
+    int w_max: largest total w of the SDs
+    unsigned char* present: 1 for the SDs in the basis, or NULL
+
+  Output(s):
+    jump_table* a11_jumps_i: jumps at a11_jumps_i[i_parity + 2*(i_mj + num_mj*(b + a*n_s))]
+*/
+  jump_split split;
+  jump_split_start(&split, n_sds_i, 1, a11_jumps_i, NULL, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a11_chunk = jump_split_view(&split, 0, c);
+      sd_walk walk;
+      sd_walk_start_trunc(&walk, n_s, n_p, NULL, l_shell, jz_shell, w_shell, w_max);
+      for (sd_walk_seek(&walk, split.first[c]); (walk.p != 0) && (walk.p < split.first[c + 1]); sd_walk_next(&walk)) {
+        int j = walk.p;
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (sd.parity + 1)/2;
+        for (int k = 0; k < n_p; k++) {
+          int b = walk.orbitals[k] - 1;
+          for (int a = 0; a < n_s; a++) {
+            if ((jz_shell[a] != jz_shell[b]) || ((l_shell[a] - l_shell[b]) % 2 != 0)) {continue;}
+            if ((w_shell != NULL) && (sd.w + w_shell[a] - w_shell[b] > w_max)) {continue;}
+            int phase;
+            unsigned int pf = sd_mask_hop(n_s, n_p, &walk.mask, walk.n_words, a + 1, b + 1, &phase);
+            if ((pf == 0) || (pf > (unsigned int) n_sds_i)) {continue;}
+            if ((present != NULL) && !present[pf]) {continue;}
+            jump_table_add(a11_chunk, i_parity + 2*(i_mj + num_mj*(b + a*n_s)), j, pf, phase, 0);
+          }
+        }
+      }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
+  }
 
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
+  jump_split_finish(&split);
+  return;
+}
 
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*a)] = create_sd_node(j, pn, phase, NULL);
-      } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*a)], j, pn, phase);
+void build_one_body_jumps_i_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i,  int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present) {
+
+  jump_split split;
+  jump_split_start(&split, n_sds_i, 1, a0_jumps_i, a1_jumps_i, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      sd_walk walk;
+      // Only the SDs within the truncation are generated
+      sd_walk_start_trunc(&walk, n_s, n_p, NULL, l_shell, jz_shell, w_shell, w_max);
+      for (sd_walk_seek(&walk, split.first[c]); (walk.p != 0) && (walk.p < split.first[c + 1]); sd_walk_next(&walk)) {
+        int j = walk.p;
+
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (sd.parity + 1)/2;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), j, pn, phase, 0);
+        }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
   return;
 }
 
-void build_one_body_jumps_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, sd_list** a1_list_f, int* jz_shell, int* l_shell, int* w_shell, int w_max) {
+void build_one_body_jumps_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a1_jumps_f, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present) {
   
-  for (int j = 1; j <= n_sds_f; j++) {
-     if (w_from_p(j, n_s, n_p, w_shell) > w_max) {continue;}
-     int j_min = j_min_from_p(n_s, n_p, j);
-
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      float mj = m_from_p(pn, n_s, n_p - 1, jz_shell);
-      if ((mj > mj_max) || (mj < mj_min)) {continue;}
-      int i_mj = mj - mj_min;
-      int i_parity = (parity_from_p(pn, n_s, n_p - 1, l_shell) + 1)/2;
-
-      a1_array_f[(pn - 1) + a*n_sds_int] = j*phase;
-      if (a1_list_f[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-       a1_list_f[i_parity + 2*(i_mj + num_mj*a)] = create_sd_node(pn, j, phase, NULL);
-      } else {
-        sd_append(a1_list_f[i_parity + 2*(i_mj + num_mj*a)], pn, j, phase);
-      }
+  jump_split split;
+  jump_split_start(&split, n_sds_f, rev_map_parallel(a1_map_f), a1_jumps_f, NULL, NULL);
+  for (int pass = (a1_jumps_f == NULL); pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a1_chunk = jump_split_view(&split, 0, c);
+      sd_walk walk;
+      // Only the SDs within the truncation are generated
+      sd_walk_start_trunc(&walk, n_s, n_p, NULL, NULL, NULL, w_shell, w_max);
+      for (sd_walk_seek(&walk, split.first[c]); (walk.p != 0) && (walk.p < split.first[c + 1]); sd_walk_next(&walk)) {
+        int j = walk.p;
+    
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          sd_info sd_pn;
+          decode_sd(pn, n_s, n_p - 1, NULL, l_shell, jz_shell, NULL, NULL, &sd_pn);
+          float mj = sd_pn.mj;
+          if ((mj > mj_max) || (mj < mj_min)) {continue;}
+          int i_mj = mj - mj_min;
+          int i_parity = (sd_pn.parity + 1)/2;
+
+          if (pass == 1) {rev_map_set(a1_map_f, pn, a, j*phase);}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), pn, j, phase, 0);
 
+        }
+      }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
   return;
 }
 
 
-void build_one_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wf_list** a0_list_i, sd_list** a1_list_i,  int* jz_shell, int* l_shell) {
-
-  for (int j = 1; j <= n_sds_i; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj < mj_min) || (mj > mj_max)) {continue;}
-    int i_mj = mj - mj_min;
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-    if (a0_list_i[i_parity + 2*i_mj] == NULL) {
-      a0_list_i[i_parity + 2*i_mj] = create_wf_node(j, NULL);
-    } else {
-      wf_append(a0_list_i[i_parity + 2*i_mj], j);
-    }
-
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      if (a1_list_i[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_i[i_parity + 2*(i_mj + num_mj*a)] = create_sd_node(j, pn, phase, NULL);
-      } else {
-        sd_append(a1_list_i[i_parity + 2*(i_mj + num_mj*a)], j, pn, phase);
+void build_one_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i,  int* jz_shell, int* l_shell, unsigned char* present) {
+
+  jump_split split;
+  jump_split_start(&split, n_sds_i, 1, a0_jumps_i, a1_jumps_i, NULL);
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a0_chunk = jump_split_view(&split, 0, c);
+      jump_table *a1_chunk = jump_split_view(&split, 1, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj < mj_min) || (mj > mj_max)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (sd.parity + 1)/2;
+        jump_table_add(a0_chunk, i_parity + 2*i_mj, j, 0, 0, 0);
+
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), j, pn, phase, 0);
+        }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
   return;
 }
 
-void build_one_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, sd_list** a1_list_f, int* jz_shell, int* l_shell) {
+void build_one_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a1_jumps_f, int* jz_shell, int* l_shell, unsigned char* present) {
   
-  for (int j = 1; j <= n_sds_f; j++) {
-    int j_min = j_min_from_p(n_s, n_p, j);
-    float mj = m_from_p(j, n_s, n_p, jz_shell);
-    if ((mj > mj_max) || (mj < mj_min)) {continue;}
-    int i_mj = mj - mj_min;
-    int i_parity = (parity_from_p(j, n_s, n_p, l_shell) + 1)/2;
-
-    for (int a = j_min - 1; a < n_s; a++) {
-      int phase;
-      int pn = a_op(n_s, n_p, j, a + 1, &phase, j_min);
-      if (pn == 0) {continue;}
-      a1_array_f[(pn - 1) + a*n_sds_int] = j*phase;
-      //float mj = m_from_p(pn, n_s, n_p - 1, jz_shell);
-      //if ((mj > mj_max) || (mj < mj_min)) {continue;}
-      //int i_mj = mj - mj_min;
-      //int i_parity = (parity_from_p(pn, n_s, n_p - 1, l_shell) + 1)/2;
-      if (a1_list_f[i_parity + 2*(i_mj + num_mj*a)] == NULL) {
-        a1_list_f[i_parity + 2*(i_mj + num_mj*a)] = create_sd_node(pn, j, phase, NULL);
-      } else {
-        sd_append(a1_list_f[i_parity + 2*(i_mj + num_mj*a)], pn, j, phase);
+  jump_split split;
+  jump_split_start(&split, n_sds_f, rev_map_parallel(a1_map_f), a1_jumps_f, NULL, NULL);
+  for (int pass = (a1_jumps_f == NULL); pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < split.n_chunks; c++) {
+      jump_table *a1_chunk = jump_split_view(&split, 0, c);
+      sd_walk walk;
+      sd_walk_start(&walk, n_s, n_p, NULL, l_shell, jz_shell, NULL);
+      sd_walk_seek(&walk, split.first[c]);
+      for (int j = split.first[c]; (j < (int) split.first[c + 1]) && (walk.p != 0); j++, sd_walk_next(&walk)) {
+    
+        if ((present != NULL) && !present[j]) {continue;}
+        sd_info sd = walk.sd;
+        int j_min = sd.j_min;
+        float mj = sd.mj;
+        if ((mj > mj_max) || (mj < mj_min)) {continue;}
+        int i_mj = mj - mj_min;
+        int i_parity = (sd.parity + 1)/2;
+
+        for (int a = j_min - 1; a < n_s; a++) {
+          int phase;
+          sd_bits mask_pn;
+          int pn = sd_annihilate(n_s, n_p, j, &walk.mask, walk.n_words, a + 1, &phase, j_min, &mask_pn);
+          if (pn == 0) {continue;}
+          if (pass == 1) {rev_map_set(a1_map_f, pn, a, j*phase);}
+          //float mj = m_from_p(pn, n_s, n_p - 1, jz_shell);
+          //if ((mj > mj_max) || (mj < mj_min)) {continue;}
+          //int i_mj = mj - mj_min;
+          //int i_parity = (parity_from_p(pn, n_s, n_p - 1, l_shell) + 1)/2;
+          jump_table_add(a1_chunk, i_parity + 2*(i_mj + num_mj*a), pn, j, phase, 0);
+        }
       }
+      sd_walk_free(&walk);
     }
+    if (pass == 0) {jump_split_begin_fill(&split);}
   }
 
+  jump_split_finish(&split);
+  rev_map_finish(a1_map_f);
   return;
 }
 
-void trace_1body_t0_nodes_spec(int a, int b, int num_mj, int n_sds_int, int* a1_array_f, sde_list** a1_list_i, wfe_list** a0_list_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+void trace_1body_t0_nodes_spec(int a, int b, int num_mj, rev_map* a1_map_f, jump_table* a1_jumps_i, jump_table* a0_jumps_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_T0_SPEC, a, b, -1, -1, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_T0_SPEC, a, b, -1, -1, i_op, 1);
+  }
 
   int ns = wd->n_shells;
 
   for (int ipar = 0; ipar <= 1; ipar++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sde_list* node1 = a1_list_i[ipar + 2*(imj + num_mj*b)];
-      while (node1 != NULL) {
-        unsigned int ppn = node1->pn;
-        unsigned int ppi = node1->pi;
-        int phase1 = node1->phase;
-        int ppf = a1_array_f[(ppn - 1) + n_sds_int*a];
-        if (ppf == 0) {node1 = node1->next; continue;}
+      size_t row1 = ipar + 2*(imj + num_mj*b);
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a1_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppn = j1.pn;
+        unsigned int ppi = j1.pi;
+        int phase1 = j1.phase;
+        int ppf = rev_map_get(a1_map_f, ppn, a);
+        if (ppf == 0) {continue;}
         int phase2 = 1;
         if (ppf < 0) {
           ppf *= -1;
  	  phase2 = -1;
         }
-        int n_quanta_1 = node1->n_quanta;
-        node1 = node1->next;
-        wfe_list* node2 = a0_list_i[ipar + 2*(num_mj - imj - 1)];
-        while (node2 != NULL) {
-  	  int pn = node2->p;
-	  int index_i = -1;
-	  int index_f = -1;
-          int i_spec = n_quanta_1 + node2->n_quanta - n_q_spec_min;
+        int n_quanta_1 = j1.n_quanta;
+        size_t row2 = ipar + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a0_jumps_i, row2); jump_cursor_next(&j2);) {
+  	  int pn = j2.pi;
+	  basis_int index_i = -1;
+	  basis_int index_f = -1;
+          int i_spec = n_quanta_1 + j2.n_quanta - n_q_spec_min;
 	  if (i_op == 0) {
-	    unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pn % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pn) && (ppi == node3->pp)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pn % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pn) && (ppf == node3->pp)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, ppi, pn);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, ppf, pn);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -2855,27 +4097,12 @@ void trace_1body_t0_nodes_spec(int a, int b, int num_mj, int n_sds_int, int* a1_
               eig_pair = eig_pair->next;
             }
 	  } else {
-	    unsigned int p_hash_i = pn + wd->n_sds_p_i*(ppi % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pp) && (ppi == node3->pn)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = pn + wd->n_sds_p_f*(ppf % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pp) && (ppf == node3->pn)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, pn, ppi);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, pn, ppf);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -2886,60 +4113,59 @@ void trace_1body_t0_nodes_spec(int a, int b, int num_mj, int n_sds_int, int* a1_
               eig_pair = eig_pair->next;
             }
 	  } 
-	  node2 = node2->next;
         } 
       }
     }
   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void trace_1body_t2_nodes_spec(int a, int b, int num_mj, sde_list** a1_list_i, sde_list** a1_list_f, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
+void trace_1body_t2_nodes_spec(int a, int b, int num_mj, jump_table* a1_jumps_i, jump_table* a1_jumps_f, wfnData* wd, int i_op, eigen_list *transition, double* density, int n_q_spec_min, int n_spec_bins) {
 /* 
 
 */
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_T2_SPEC, a, b, -1, -1, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, n_spec_bins);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_T2_SPEC, a, b, -1, -1, i_op, 1);
+  }
   int ns = wd->n_shells;
   for (int ipar = 0; ipar <= 1; ipar++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sde_list* node1 = a1_list_i[ipar + 2*(imj + num_mj*b)];
+      size_t row1 = ipar + 2*(imj + num_mj*b);
       // Loop over final states resulting from 2x a_op
-      while (node1 != NULL) {
-        unsigned int ppf = node1->pn; // Get final state p_f
-        unsigned int ppi = node1->pi; // Get initial state p_i
-        int phase1 = node1->phase;
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a1_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppf = j1.pn; // Get final state p_f
+        unsigned int ppi = j1.pi; // Get initial state p_i
+        int phase1 = j1.phase;
         // Get list of n_i associated to p_i
-        sde_list* node2 = a1_list_f[ipar + 2*(num_mj - imj - 1 + num_mj*a)]; //hash corresponds to a_op operators
+        size_t row2 = ipar + 2*(num_mj - imj - 1 + num_mj*a); //hash corresponds to a_op operators
         // Loop over n_f  
         //int m_pf = m_from_p(ppf, ns, npp, wd->jz_shell);
-        while (node2 != NULL) {
-          unsigned int pni = node2->pi;
-          unsigned int pnf = node2->pn;
-          int phase2 = node2->phase;
-          int i_spec = node1->n_quanta + node2->n_quanta - n_q_spec_min;
-          int index_i = -1;
-          int index_f = -1;
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a1_jumps_f, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          int phase2 = j2.phase;
+          int i_spec = j1.n_quanta + j2.n_quanta - n_q_spec_min;
+          basis_int index_i = -1;
+          basis_int index_f = -1;
           if (i_op == 0) {
-	    unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pni % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pni == node3->pn) && (ppi == node3->pp)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pnf % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pnf == node3->pn) && (ppf == node3->pp)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, ppi, pni);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, ppf, pnf);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -2950,27 +4176,12 @@ void trace_1body_t2_nodes_spec(int a, int b, int num_mj, sde_list** a1_list_i, s
               eig_pair = eig_pair->next;
             }
 	  } else {
-	    unsigned int p_hash_i = pni + wd->n_sds_p_i*(ppi % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pni == node3->pp) && (ppi == node3->pn)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = pnf + wd->n_sds_p_f*(ppf % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pnf == node3->pp) && (ppf == node3->pn)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, pni, ppi);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, pnf, ppf);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, i_spec)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -2981,31 +4192,42 @@ void trace_1body_t2_nodes_spec(int a, int b, int num_mj, sde_list** a1_list_i, s
               eig_pair = eig_pair->next;
             }
 	  }
-          node2 = node2->next;
         }
-        node1 = node1->next;
       }
     }  
   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, n_spec_bins);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
 
-void trace_1body_t0_nodes(int a, int b, int num_mj, int n_sds_int, int* a1_array_f, sd_list** a1_list_i, wf_list** a0_list_i, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+void trace_1body_t0_nodes(int a, int b, int num_mj, rev_map* a1_map_f, jump_table* a1_jumps_i, jump_table* a0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_T0, a, b, -1, -1, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_T0, a, b, -1, -1, i_op, 0);
+  }
 
   int ns = wd->n_shells;
 
   for (int ipar1 = 0; ipar1 <= 1; ipar1++) {
     for (int imj = 0; imj < num_mj; imj++) {
-      sd_list* node1 = a1_list_i[ipar1 + 2*(imj + num_mj*b)];
-      while (node1 != NULL) {
-        unsigned int ppn = node1->pn;
-        unsigned int ppi = node1->pi;
-        int phase1 = node1->phase;
-        int ppf = a1_array_f[(ppn - 1) + n_sds_int*a];
-        if (ppf == 0) {node1 = node1->next; continue;}
+      size_t row1 = ipar1 + 2*(imj + num_mj*b);
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a1_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppn = j1.pn;
+        unsigned int ppi = j1.pi;
+        int phase1 = j1.phase;
+        int ppf = rev_map_get(a1_map_f, ppn, a);
+        if (ppf == 0) {continue;}
         int phase2 = 1;
-        node1 = node1->next;
         if (ppf < 0) {
         ppf *= -1;
  	phase2 = -1;
@@ -3025,34 +4247,20 @@ void trace_1body_t0_nodes(int a, int b, int num_mj, int n_sds_int, int* a1_array
 		}
 	} else {printf("Parity error\n"); exit(0);}
 
-        wf_list* node2 = a0_list_i[ipar2 + 2*(num_mj - imj - 1)];
-        while (node2 != NULL) {
-	  int pn = node2->p;
-   	  int index_i = -1;
-	  int index_f = -1;
+        size_t row2 = ipar2 + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a0_jumps_i, row2); jump_cursor_next(&j2);) {
+	  int pn = j2.pi;
+   	  basis_int index_i = -1;
+	  basis_int index_f = -1;
 
 	  if (i_op == 0) {
-	    unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pn % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pn) && (ppi == node3->pp)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pn % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pn) && (ppf == node3->pp)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, ppi, pn);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, ppf, pn);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -3063,27 +4271,12 @@ void trace_1body_t0_nodes(int a, int b, int num_mj, int n_sds_int, int* a1_array
               eig_pair = eig_pair->next;
             }
 	  } else {
-	    unsigned int p_hash_i = pn + wd->n_sds_p_i*(ppi % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pp) && (ppi == node3->pn)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = pn + wd->n_sds_p_f*(ppf % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pn == node3->pp) && (ppf == node3->pn)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, pn, ppi);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, pn, ppf);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -3094,18 +4287,92 @@ void trace_1body_t0_nodes(int a, int b, int num_mj, int n_sds_int, int* a1_array
               eig_pair = eig_pair->next;
             }
 	  } 
-	  node2 = node2->next;
         } 
       }
     }
   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
-void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj_2, float mj_min_2, sd_list** a1_list_i, sd_list** a1_list_f, wfnData* wd, int i_op, eigen_list *transition, double* density) {
+void trace_1body_t0_hops(int a, int b, int num_mj, jump_table* a11_jumps_i, jump_table* a0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density) {
+/* Same-species one-body trace from the direct a+(a) a(b) lists of build_one_body_hops_trunc
+   Gives the pairs of trace_1body_t0_nodes, and shares its resolved tables, without the
+   reverse lookup through the intermediate SD
+*/
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_T0, a, b, -1, -1, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_T0, a, b, -1, -1, i_op, 0);
+  }
+
+  int ns = wd->n_shells;
+  if ((wd->parity_i != '+') && (wd->parity_i != '-')) {printf("Parity error\n"); exit(0);}
+  for (int ipar1 = 0; ipar1 <= 1; ipar1++) {
+    int ipar2 = (wd->parity_i == '+') ? ipar1 : 1 - ipar1;
+    for (int imj = 0; imj < num_mj; imj++) {
+      size_t row1 = ipar1 + 2*(imj + num_mj*(b + a*ns));
+      jump_cursor j1;
+      for (jump_cursor_init(&j1, a11_jumps_i, row1); jump_cursor_next(&j1);) {
+        unsigned int ppi = j1.pi;
+        unsigned int ppf = j1.pn;
+        int phase = j1.phase;
+        size_t row2 = ipar2 + 2*(num_mj - imj - 1);
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a0_jumps_i, row2); jump_cursor_next(&j2);) {
+          int pn = j2.pi;
+          basis_int index_i, index_f;
+          if (i_op == 0) {
+            index_i = basis_lookup(wd->basis_i, ppi, pn);
+            if (index_i < 0) {continue;}
+            index_f = basis_lookup(wd->basis_f, ppf, pn);
+          } else {
+            index_i = basis_lookup(wd->basis_i, pn, ppi);
+            if (index_i < 0) {continue;}
+            index_f = basis_lookup(wd->basis_f, pn, ppf);
+          }
+          if (index_f < 0) {continue;}
+          if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase, 0)) {continue;}
+          eigen_list* eig_pair = transition;
+          int i_trans = 0;
+          while (eig_pair != NULL) {
+            int psi_i = eig_pair->eig_i;
+            int psi_f = eig_pair->eig_f;
+            density[i_trans] += wd->bc_i[psi_i + wd->n_eig_i*index_i]*wd->bc_f[psi_f + wd->n_eig_f*index_f]*phase;
+            i_trans++;
+            eig_pair = eig_pair->next;
+          }
+        }
+      }
+    }
+  }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
+  return;
+}
+
+void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj_2, float mj_min_2, jump_table* a1_jumps_i, jump_table* a1_jumps_f, wfnData* wd, int i_op, eigen_list *transition, double* density) {
 /* 
 
 */
+  resolved_table *resolved = NULL;
+  if (wd->jumps != NULL) {
+    resolved_table *table = resolved_find(wd->jumps, RESOLVED_T2, a, b, -1, -1, i_op);
+    if (table != NULL) {
+      trace_resolved_table(wd, table, transition, density, 1);
+      return;
+    }
+    resolved = resolved_begin(wd->jumps, RESOLVED_T2, a, b, -1, -1, i_op, 0);
+  }
   int ns = wd->n_shells;
   for (int imj1 = 0; imj1 < num_mj_1; imj1++) {
     float mj1 = imj1 + mj_min_1;
@@ -3128,45 +4395,32 @@ void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj
 			ipar2 = 0;
 		}
 	} else {printf("Parity error\n"); exit(0);}
-        sd_list* node1 = a1_list_i[ipar1 + 2*(imj1 + num_mj_1*b)];
+        size_t row1 = ipar1 + 2*(imj1 + num_mj_1*b);
         // Loop over final states resulting from 2x a_op
-        while (node1 != NULL) {
-          unsigned int ppf = node1->pn; // Get final state p_f
-          unsigned int ppi = node1->pi; // Get initial state p_i
-          int phase1 = node1->phase;
+        jump_cursor j1;
+        for (jump_cursor_init(&j1, a1_jumps_i, row1); jump_cursor_next(&j1);) {
+          unsigned int ppf = j1.pn; // Get final state p_f
+          unsigned int ppi = j1.pi; // Get initial state p_i
+          int phase1 = j1.phase;
 		//if (ipar == 0) {ipar2 = 0;} else {ipar2 = 1;}
-          sd_list* node2 = a1_list_f[ipar2 + 2*(imj2 + num_mj_2*a)]; //hash corresponds to a_op operators
+          size_t row2 = ipar2 + 2*(imj2 + num_mj_2*a); //hash corresponds to a_op operators
 
         // Loop over n_f  
         //int m_pf = m_from_p(ppf, ns, npp, wd->jz_shell);
-        while (node2 != NULL) {
-          unsigned int pni = node2->pi;
-          unsigned int pnf = node2->pn;
-          int phase2 = node2->phase;
-          int index_i = -1;
-          int index_f = -1;  
+        jump_cursor j2;
+        for (jump_cursor_init(&j2, a1_jumps_f, row2); jump_cursor_next(&j2);) {
+          unsigned int pni = j2.pi;
+          unsigned int pnf = j2.pn;
+          int phase2 = j2.phase;
+          basis_int index_i = -1;
+          basis_int index_f = -1;  
           if (i_op == 0) {
-	    unsigned int p_hash_i = ppi + wd->n_sds_p_i*(pni % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pni == node3->pn) && (ppi == node3->pp)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = ppf + wd->n_sds_p_f*(pnf % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pnf == node3->pn) && (ppf == node3->pp)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, ppi, pni);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, ppf, pnf);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -3177,27 +4431,12 @@ void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj
               eig_pair = eig_pair->next;
             }
 	  } else {
-	    unsigned int p_hash_i = pni + wd->n_sds_p_i*(ppi % HASH_SIZE);
-	    wh_list* node3 = wd->wh_hash_i[p_hash_i];
-	    while (node3 != NULL) {
-	      if ((pni == node3->pp) && (ppi == node3->pn)) {
-	        index_i = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_i < 0) {node2 = node2->next; continue;}
-
-	    unsigned int p_hash_f = pnf + wd->n_sds_p_f*(ppf % HASH_SIZE);
-	    node3 = wd->wh_hash_f[p_hash_f];
-	    while (node3 != NULL) {
-	      if ((pnf == node3->pp) && (ppf == node3->pn)) {
-	        index_f = node3->index;
-	        break;
-	      }
-	      node3 = node3->next;
-	    }
-	    if (index_f < 0) {node2 = node2->next; continue;}
+	    index_i = basis_lookup(wd->basis_i, pni, ppi);
+	    if (index_i < 0) {continue;}
+
+	    index_f = basis_lookup(wd->basis_f, pnf, ppf);
+	    if (index_f < 0) {continue;}
+            if ((resolved != NULL) && resolved_push(resolved, index_i, index_f, phase1*phase2, 0)) {continue;}
             eigen_list* eig_pair = transition;
             int i_trans = 0;
             while (eig_pair != NULL) {
@@ -3208,14 +4447,16 @@ void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj
               eig_pair = eig_pair->next;
             }
 	  } 
-          node2 = node2->next;
 	}
-        node1 = node1->next;
 	}
 //	}
       }
     }  
   }
+  if (resolved != NULL) {
+    trace_resolved_table(wd, resolved, transition, density, 1);
+    resolved_store(wd->jumps, resolved);
+  }
   return;
 }
 
@@ -2,6 +2,55 @@
 #define DENSITY_H
 #include "file_io.h"
 
+// What a jump builder depends on besides the shells, builders with equal keys produce the same jumps
+typedef struct jump_key
+{
+  int n_s, n_p;
+  float mj_min, mj_max;
+  int num_mj;
+  int w_max; // truncation, -1 if none
+  unsigned int n_sds;
+  unsigned char *present; // SDs kept by BASIS_PRUNE_SDS, NULL for all
+} jump_key;
+
+int jump_keys_match(const jump_key* x, const jump_key* y);
+
+// Trace kernels a density run can reach
+#define KERNEL_A4 1
+#define KERNEL_A22 2
+#define KERNEL_A20 4
+#define KERNEL_T0 8
+#define KERNEL_T2 16
+
+// Bit of the a_r table or map of a species in a jump plan
+#define PLAN_A(r) (1 << (r))
+
+// Tables and maps a density run builds for the kernels its operator reaches, index 0 for protons and 1 for neutrons
+typedef struct jump_plan
+{
+  int kernels;
+  int jumps_i[2]; // PLAN_A(r) set if the a_r table of the initial SDs is built
+  int jumps_f[2]; // same for the tables of the final SDs
+  int maps_f[2]; // PLAN_A(r) set if the a_r reverse map to the final SDs is built
+  int hops_i[2]; // 1 if the a+a hop table of the initial SDs is built (ONE_BODY_HOPS)
+  int share_i, share_f; // neutrons use the proton tables (maps)
+} jump_plan;
+
+// Created-species jumps of trace_a22_nodes_compose for the pair (a, b) they were last built for
+typedef struct pair_jumps
+{
+  int a, b, i_op;
+  jump_table *f_jumps;
+} pair_jumps;
+
+jump_plan plan_two_body_jumps(float mt_op, int compose, int share_i, int share_f);
+jump_plan plan_one_body_jumps(float mt_op, int one_hop, int share_i, int share_f);
+void log_jump_plan(const jump_plan* plan, wfnData* wd, int num_mj, int with_quanta);
+jump_table* jump_table_planned(arena* pool, int planned, size_t n_rows, int with_pn, int with_quanta);
+rev_map* rev_map_planned(int planned, int n_s, int n_p_int, int n_created, int mode);
+jump_table* pair_jumps_get(pair_jumps* pairs, int a, int b, int num_mj, rev_map* b2_map_f, jump_table* b0_jumps_i, wfnData* wd, int i_op, int with_quanta);
+void pair_jumps_free(pair_jumps* pairs);
+
 void one_body_density(speedParams* sp);
  
 void one_body_density_trunc(speedParams* sp);
@@ -14,58 +63,78 @@ void two_body_density_trunc(speedParams* sp);
 
 void two_body_density_spec(speedParams* sp);
 
-void trace_a4_nodes(int a, int b, int c, int d, int num_mj, int n_sds_int2, int* p2_array_f, sd_list** p1_list_i, wf_list** n0_list_i, wfnData* wd, int i_op, eigen_list* transition, double* density);
+void trace_a4_nodes(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p1_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density);
+
+void trace_a22_nodes(int a, int b, int c, int d, int num_mj, jump_table* a2_jumps_i, jump_table* a2_jumps_f, wfnData* wd, int i_op, eigen_list* transition, double* density);
+
+void trace_a4_nodes_compose(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p1_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density);
+
+void trace_a22_nodes_compose(int a, int b, int c, int d, int num_mj, jump_table* a1_jumps_i, jump_table* f_jumps, wfnData* wd, int i_op, eigen_list* transition, double* density);
+
+void trace_a20_nodes(int a, int b, int c, int d, int num_mj, jump_table* p1_jumps_i, jump_table* n1_jumps_i, rev_map* p1_map_f, rev_map* n1_map_f, wfnData* wd, eigen_list* transition, double* density); 
+
+void trace_a22_nodes_join(int a, int b, int c, int d, int num_mj, jump_table* a2_jumps_i, jump_table* a2_jumps_f, wfnData* wd, int i_op, eigen_list* transition, double* density);
+
+void trace_a20_nodes_join(int a, int b, int c, int d, int num_mj, jump_table* p1_jumps_i, jump_table* n1_jumps_i, rev_map* p1_map_f, rev_map* n1_map_f, wfnData* wd, eigen_list* transition, double* density);
+
+void trace_resolved_table(wfnData* wd, resolved_table* table, eigen_list* transition, double* density, int n_spec_bins);
+
+void trace_join_sector(wfnData* wd, long long int n_query, wh_query* query_i, wh_query* query_f, int* phase, eigen_list* transition, double* density);
+
+void build_two_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a2_jumps_f, int* jz_shell, int* l_shell, unsigned char* present);
+
+void build_two_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, unsigned char* present);
 
-void trace_a22_nodes(int a, int b, int c, int d, int num_mj, sd_list** a2_list_i, sd_list** a2_list_f, wfnData* wd, int i_op, eigen_list* transition, double* density);
+void build_two_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, unsigned char* present);
 
-void trace_a20_nodes(int a, int b, int c, int d, int num_mj, int n_sds_p_int1, int n_sds_n_int1, sd_list** p1_list_i, sd_list** n1_list_i, int* p1_list_f, int* n1_list_f, wfnData* wd, eigen_list* transition, double* density); 
+void build_two_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present);
 
-void build_two_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, sd_list** a2_list_f, int* jz_shell, int* l_shell);
+void trace_a4_nodes_spec(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p1_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int min_n_spec_q, int n_spec_bins);
 
-void build_two_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wf_list** a0_list_i, sd_list** a1_list_i, sd_list** a2_list_i, int* jz_shell, int* l_shell);
+void trace_a22_nodes_spec(int a, int b, int c, int d, int num_mj, jump_table* a2_jumps_i, jump_table* a2_jumps_f, wfnData* wd, int i_op, eigen_list* transition, double* density, int min_n_spec_q, int n_spec_bins);
 
-void build_two_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, wf_list** a0_list_i, sd_list** a1_list_i, sd_list** a2_list_i, int* jz_shell, int* l_shell);
+void trace_a4_nodes_spec_compose(int a, int b, int c, int d, int num_mj, rev_map* p2_map_f, jump_table* p1_jumps_i, jump_table* n0_jumps_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int min_n_spec_q, int n_spec_bins);
 
-void build_two_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, wf_list** a0_list_i, sd_list** a1_list_i, sd_list** a2_list_i, int* jz_shell, int* l_shell, int* w_shell, int w_max);
+void trace_a22_nodes_spec_compose(int a, int b, int c, int d, int num_mj, jump_table* a1_jumps_i, jump_table* f_jumps, wfnData* wd, int i_op, eigen_list* transition, double* density, int min_n_spec_q, int n_spec_bins);
 
-void trace_a4_nodes_spec(int a, int b, int c, int d, int num_mj, int n_sds_int2, int* p2_array_f, sde_list** p1_list_i, wfe_list** n0_list_i, wfnData* wd, int i_op, eigen_list *transition, double* density, int min_n_spec_q, int n_spec_bins);
+void trace_a20_nodes_spec(int a, int b, int c, int d, int num_mj, jump_table* p1_jumps_i, jump_table* n1_jumps_i, rev_map* p1_map_f, rev_map* n1_map_f, wfnData* wd, eigen_list *transition, double* density, int min_n_spec_q, int n_spec_bins); 
 
-void trace_a22_nodes_spec(int a, int b, int c, int d, int num_mj, sde_list** a2_list_i, sde_list** a2_list_f, wfnData* wd, int i_op, eigen_list* transition, double* density, int min_n_spec_q, int n_spec_bins);
+void build_two_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a2_jumps_f, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present);
 
-void trace_a20_nodes_spec(int a, int b, int c, int d, int num_mj, int n_sds_p_int1, int n_sds_n_int1, sde_list** p1_list_i, sde_list** n1_list_i, int* p1_list_f, int* n1_list_f, wfnData* wd, eigen_list *transition, double* density, int min_n_spec_q, int n_spec_bins); 
+void build_two_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present);
 
-void build_two_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, sde_list** a2_list_f, int* jz_shell, int* l_shell, int* n_shell);
+void build_two_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, rev_map* a2_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, jump_table* a2_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present);
 
-void build_two_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wfe_list** a0_list_i, sde_list** a1_list_i, sde_list** a2_list_i, int* jz_shell, int* l_shell, int* n_shell);
 
-void build_two_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int1, int n_sds_int2, int* a1_array_f, int* a2_array_f, wfe_list** a0_list_i, sde_list** a1_list_i, sde_list** a2_list_i, int* jz_shell, int* l_shell, int* n_shell);
+void trace_1body_t0_nodes(int a, int b, int num_mj, rev_map* a1_map_f, jump_table* a1_jumps_i, jump_table* a0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double *density);
 
+void trace_1body_t0_hops(int a, int b, int num_mj, jump_table* a11_jumps_i, jump_table* a0_jumps_i, wfnData* wd, int i_op, eigen_list* transition, double* density);
 
-void trace_1body_t0_nodes(int a, int b, int num_mj, int n_sds_int, int* a1_array_f, sd_list** a1_list_i, wf_list** a0_list_i, wfnData* wd, int i_op, eigen_list* transition, double *density);
+void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj_2, float mj_min_2, jump_table* a1_jumps_i, jump_table* a1_jumps_f, wfnData* wd, int i_op, eigen_list *transition, double* density);
 
-void trace_1body_t2_nodes(int a, int b, int num_mj_1, float mj_min_1, int num_mj_2, float mj_min_2, sd_list** a1_list_i, sd_list** a1_list_f, wfnData* wd, int i_op, eigen_list *transition, double* density);
+void build_one_body_jumps_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a1_jumps_f, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present);
 
-void build_one_body_jumps_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, sd_list** a1_list_f, int* jz_shell, int* l_shell, int* w_shell, int w_max);
+void build_one_body_hops_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a11_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present);
 
-void build_one_body_jumps_i_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wf_list** a0_list_i, sd_list** a1_list_i, int* jz_shell, int* l_shell, int* w_shell, int w_max);
+void build_one_body_jumps_i_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present);
 
 
-void build_one_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, sd_list** a1_list_f, int* jz_shell, int* l_shell);
+void build_one_body_jumps_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a1_jumps_f, int* jz_shell, int* l_shell, unsigned char* present);
 
-void build_one_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wf_list** a0_list_i, sd_list** a1_list_i, int* jz_shell, int* l_shell);
+void build_one_body_jumps_i(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, unsigned char* present);
 
-void build_one_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, wf_list** a0_list_i, sd_list** a1_list_i, int* jz_shell, int* l_shell, int* w_shell, int w_max);
+void build_one_body_jumps_i_and_f_trunc(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, int* w_shell, int w_max, unsigned char* present);
 
-void build_one_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, wf_list** a0_list_i, sd_list** a1_list_i, int* jz_shell, int* l_shell);
+void build_one_body_jumps_i_and_f(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, unsigned char* present);
 
-void trace_1body_t0_nodes_spec(int a, int b, int num_mj, int n_sds_int, int* a1_array_f, sde_list** a1_list_i, wfe_list** a0_list_i, wfnData* wd, int i_op, eigen_list *transition, double *density, int n_q_spec_min, int n_spec_bins);
+void trace_1body_t0_nodes_spec(int a, int b, int num_mj, rev_map* a1_map_f, jump_table* a1_jumps_i, jump_table* a0_jumps_i, wfnData* wd, int i_op, eigen_list *transition, double *density, int n_q_spec_min, int n_spec_bins);
 
-void trace_1body_t2_nodes_spec(int a, int b, int num_mj, sde_list** a1_list_i, sde_list** a1_list_f, wfnData* wd, int i_op, eigen_list* transition, double *density, int n_q_spec_min, int n_spec_bins);
+void trace_1body_t2_nodes_spec(int a, int b, int num_mj, jump_table* a1_jumps_i, jump_table* a1_jumps_f, wfnData* wd, int i_op, eigen_list* transition, double *density, int n_q_spec_min, int n_spec_bins);
 
-void build_one_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, sde_list** a1_list_f, int* jz_shell, int* l_shell, int* n_shell);
+void build_one_body_jumps_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a1_jumps_f, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present);
 
-void build_one_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, wfe_list** a0_list_i, sde_list** a1_list_i, int* jz_shell, int* l_shell, int* n_shell);
+void build_one_body_jumps_i_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_i, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present);
 
-void build_one_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, int n_sds_int, int* a1_array_f, wfe_list** a0_list_i, sde_list** a1_list_i, int* jz_shell, int* l_shell, int* n_shell);
+void build_one_body_jumps_i_and_f_spec(int n_s, int n_p, float mj_min, float mj_max, int num_mj, int n_sds_f, rev_map* a1_map_f, jump_table* a0_jumps_i, jump_table* a1_jumps_i, int* jz_shell, int* l_shell, int* n_shell, unsigned char* present);
 
 #endif
@@ -17,6 +17,7 @@ speedParams* read_parameter_file(char *param_file) {
   if ((sp->spec_dep != 0) && (sp->spec_dep) != 1) {printf("Invalid flag for spectator dependence %d, please type only 0 or 1 here\n", sp->spec_dep); exit(0);}
   int eig_i, eig_f;
   sp->n_trans = 0;
+  sp->transition_list = NULL;
   while (fscanf(in_file, "%d,%d\n", &eig_i, &eig_f) == 2) {
     (sp->n_trans)++;
     if (sp->transition_list == NULL) {
@@ -26,9 +27,20 @@ speedParams* read_parameter_file(char *param_file) {
     }
   }
   printf("Read in %d transitions\n", sp->n_trans);
+  fclose(in_file);
   return sp;
 }
 
+void speed_params_free(speedParams *sp) {
+  if (sp == NULL) {return;}
+  free(sp->initial_file_base);
+  free(sp->final_file_base);
+  free(sp->out_file_base);
+  eigen_list_free(sp->transition_list);
+  free(sp);
+  return;
+}
+
 wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char *basis_file_initial, char *basis_file_final) {
   wfnData *wd = malloc(sizeof(*wd));
   FILE *in_file;
@@ -49,6 +61,10 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
   fread(&wd->n_proton_i, sizeof(int), 1, in_file);
   fread(&wd->n_neutron_i, sizeof(int), 1, in_file);
   wd->n_data = wd->n_proton_i + wd->n_neutron_i;
+  wd->join_a20 = MERGE_JOIN_A20;
+  wd->join_a22 = MERGE_JOIN_A22;
+  wd->jumps = NULL;
+  if (RESOLVED_JUMPS) {wd->jumps = resolved_cache_create(RESOLVED_JUMP_MAX_MB, RESOLVED_JUMP_SPILL);}
   printf("Initial state contains %d protons and %d neutrons\n", wd->n_proton_i, wd->n_neutron_i);
 
   fread(&junk, sizeof(int), 1, in_file);
@@ -84,6 +100,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
   fread(&n_sps_n, sizeof(int), 1, in_file);
   wd->n_shells = n_sps_p;
   printf("Number of single particle states: %d\n", wd->n_shells);
+  binomial_table_init(wd->n_shells);
   wd->n_shell = (int*) malloc(sizeof(int)*wd->n_shells);
   wd->j_shell = (int*) malloc(sizeof(int)*wd->n_shells);
   wd->l_shell = (int*) malloc(sizeof(int)*wd->n_shells);
@@ -124,7 +141,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
   fread(&junk, sizeof(int), 1, in_file);
   fread(&junk, sizeof(int), 1, in_file);
   fread(&wd->n_states_i, sizeof(long long int), 1, in_file);
-  printf("The model space has %d shells for a total basis size of %d\n", wd->n_shells, wd->n_states_i);
+  printf("The model space has %d shells for a total basis size of %lld\n", wd->n_shells, wd->n_states_i);
   fread(&wd->n_eig_i, sizeof(int), 1, in_file);
   printf("Initial state file contains %d eigenstates\n", wd->n_eig_i);
   if (wd->parity_i == '+') {printf("The initial state basis is positive parity\n");} 
@@ -136,6 +153,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
   wd->e_nuc_i =  (float*) malloc(sizeof(float)*wd->n_eig_i);
   wd->j_nuc_i =  (float*) malloc(sizeof(float)*wd->n_eig_i);
   wd->t_nuc_i =  (float*) malloc(sizeof(float)*wd->n_eig_i);
+  check_basis_size(wd->n_states_i, wd->n_eig_i);
   wd->bc_i = malloc(sizeof(float)*wd->n_states_i*wd->n_eig_i);
 
   printf("Reading in initial state wavefunction coefficients\n");
@@ -153,7 +171,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
     int it_nuc = round(2*t_nuc);
     wd->j_nuc_i[i] = ij_nuc/2.0;
     wd->t_nuc_i[i] = it_nuc/2.0;
-    for (int j = 0; j < wd->n_states_i; j++) {
+    for (long long int j = 0; j < wd->n_states_i; j++) {
       fread(&wd->bc_i[i + wd->n_eig_i*j], sizeof(float), 1, in_file);
       total += pow(wd->bc_i[i + wd->n_eig_i*j], 2);
  //     if ((i == 0) && j < 10) {printf("%g\n", wd->bc_i[i + wd->n_eig_i*j]);}
@@ -163,72 +181,8 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
   fclose(in_file);
   printf("Done.\n");
   printf("Reading in initial state basis\n");
-  in_file = fopen(basis_file_initial, "rb");
-  fread(&junk, sizeof(int), 1, in_file);
-  fread(&junk, sizeof(int), 1, in_file);
-  fread(&junk, sizeof(int), 1, in_file);
-  fread(&vec_offset, sizeof(int), 1, in_file);
-  fseek(in_file, vec_offset + 16, SEEK_SET);
-  for (int i = 0; i < wd->n_shells; i++) {
-  //  int w_shell;
-    fread(&junk, sizeof(int), 1, in_file);
-    fread(&wd->n_shell[i], sizeof(int), 1, in_file);
-    fread(&wd->l_shell[i], sizeof(int), 1, in_file);
-    fread(&wd->j_shell[i], sizeof(int), 1, in_file);
-    fread(&wd->jz_shell[i], sizeof(int), 1, in_file);
-    fread(&wd->w_shell[i], sizeof(int), 1, in_file);
- //   printf("%d, %d, %d, %d, %d\n", i+1, wd->n_shell[i], wd->l_shell[i], wd->j_shell[i], wd->jz_shell[i]);
-  }
-  for (int i = 0; i < wd->n_shells; i++) {
-    int n_shell, j_shell, l_shell, jz_shell, w_shell;
-    fread(&junk, sizeof(int), 1, in_file);
-    fread(&n_shell, sizeof(int), 1, in_file);
-    fread(&l_shell, sizeof(int), 1, in_file);
-    fread(&j_shell, sizeof(int), 1, in_file);
-    fread(&jz_shell, sizeof(int), 1, in_file);
-    fread(&w_shell, sizeof(int), 1, in_file);
-
-  }
-
-  wd->wh_hash_i = (wh_list**) calloc(wd->n_sds_p_i*HASH_SIZE, sizeof(wh_list*));
-  int *p_orbitals = (int*) malloc(sizeof(int)*wd->n_proton_i);
-  int *n_orbitals = (int*) malloc(sizeof(int)*wd->n_neutron_i);
-  int pp0 = gsl_sf_choose(wd->n_shells, wd->n_proton_i);
-  int pn0 = gsl_sf_choose(wd->n_shells, wd->n_neutron_i);
-  for (int i = 0; i < wd->n_states_i; i++) {
-    if (i % 1000000 == 0) {printf("%d\n", i);}
-    int in = 0;
-    int ip = 0;
-    unsigned int pp = pp0;
-    unsigned int pn = pn0;
-  //  printf("New state\n");
-    for (int j = 0; j < wd->n_data; j++) {
-      int i_state;
-      fread(&i_state, sizeof(int), 1, in_file);
- //     printf("%d\n", i_state);
-      if (i_state <= wd->n_shells) {
- //       p_orbitals[ip] = i_state;
-        pp -= n_choose_k(wd->n_shells - i_state, wd->n_proton_i - ip);
-        ip++;
-      } else {
- //       n_orbitals[in] = i_state - wd->n_shells;
-        pn -= n_choose_k(2*(wd->n_shells) - i_state, wd->n_neutron_i - in);
-        in++;
-      }
-    }
-//    unsigned int pp = p_step(wd->n_shells, wd->n_proton_i, p_orbitals);
-//    unsigned int pn = p_step(wd->n_shells, wd->n_neutron_i, n_orbitals);
-    unsigned int p_hash = pp + wd->n_sds_p_i*(pn % HASH_SIZE);
-    if (wd->wh_hash_i[p_hash] == NULL) {
-      wd->wh_hash_i[p_hash] = create_wh_node(pp, pn, i, NULL);
-    } else {
-      wh_append(wd->wh_hash_i[p_hash], pp, pn, i);
-    }
-  }
-  free(p_orbitals);
-  free(n_orbitals);
+  wd->basis_i = read_basis_index(basis_file_initial, wd, wd->n_proton_i, wd->n_neutron_i, wd->n_states_i, wd->n_sds_p_i, wd->n_sds_n_i, 1);
   printf("Done.\n");
-  fclose(in_file);
   
   if (strcmp(wfn_file_initial, wfn_file_final) == 0) {
     printf("Initial and final states are identical\n");
@@ -240,14 +194,11 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
     wd->n_sds_n_f = wd->n_sds_n_i;
     wd->jz_f = wd->jz_i;
     wd->n_eig_f = wd->n_eig_i;    
-    wd->e_nuc_f =  (float*) malloc(sizeof(float)*wd->n_eig_f);
-    wd->j_nuc_f =  (float*) malloc(sizeof(float)*wd->n_eig_f);
-    wd->t_nuc_f =  (float*) malloc(sizeof(float)*wd->n_eig_f);
     wd->e_nuc_f = wd->e_nuc_i;
     wd->j_nuc_f = wd->j_nuc_i;
     wd->t_nuc_f = wd->t_nuc_i;
     wd->bc_f = wd->bc_i;
-    wd->wh_hash_f = wd->wh_hash_i;
+    wd->basis_f = wd->basis_i;
   } else {
     printf("Initial and final states differ\n");
     wd->same_basis = 0;
@@ -320,7 +271,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
     fread(&junk, sizeof(int), 1, in_file);
     fread(&junk, sizeof(int), 1, in_file);
     fread(&wd->n_states_f, sizeof(long long int), 1, in_file);
-    printf("The model space has %d shells for a total basis size of %d\n", wd->n_shells, wd->n_states_f);
+    printf("The model space has %d shells for a total basis size of %lld\n", wd->n_shells, wd->n_states_f);
     fread(&wd->n_eig_f, sizeof(int), 1, in_file);
     printf("Final state file contains %d eigenstates\n", wd->n_eig_f);
  
@@ -334,6 +285,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
     wd->e_nuc_f = (float*) malloc(sizeof(float)*wd->n_eig_f);
     wd->j_nuc_f = (float*) malloc(sizeof(float)*wd->n_eig_f);
     wd->t_nuc_f = (float*) malloc(sizeof(float)*wd->n_eig_f);
+    check_basis_size(wd->n_states_f, wd->n_eig_f);
     wd->bc_f = malloc(sizeof(float)*wd->n_states_f*wd->n_eig_f);
 
     printf("Reading in final state wavefunction coefficients\n");
@@ -351,7 +303,7 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
       int it_nuc = round(2*t_nuc);
       wd->j_nuc_f[i] = ij_nuc/2.0;
       wd->t_nuc_f[i] = it_nuc/2.0;
-      for (int j = 0; j < wd->n_states_f; j++) {
+      for (long long int j = 0; j < wd->n_states_f; j++) {
         fread(&wd->bc_f[i + wd->n_eig_f*j], sizeof(float), 1, in_file);
         total += pow(wd->bc_f[i + wd->n_eig_f*j], 2.0);
       }
@@ -359,181 +311,344 @@ wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char
     }
     fclose(in_file);
     printf("Done.\n");
-    printf("Reading in final state basis\n");
-    in_file = fopen(basis_file_final, "rb");
-    fread(&junk, sizeof(int), 1, in_file);
-    fread(&junk, sizeof(int), 1, in_file);
-    fread(&junk, sizeof(int), 1, in_file);
-    fread(&vec_offset, sizeof(int), 1, in_file);
-    fseek(in_file, vec_offset + 16, SEEK_SET);
-    for (int i = 0; i < 2*wd->n_shells; i++) {
-      int n_shell, j_shell, l_shell, jz_shell, w_shell;
-      fread(&junk, sizeof(int), 1, in_file);
-      fread(&n_shell, sizeof(int), 1, in_file);
-      fread(&l_shell, sizeof(int), 1, in_file);
-      fread(&j_shell, sizeof(int), 1, in_file);
-      fread(&jz_shell, sizeof(int), 1, in_file);
-      fread(&w_shell, sizeof(int), 1, in_file);
-      //printf("%d, %d, %d, %d, %d\n", n_shell, l_shell, j_shell, jz_shell, w_shell);
-    }
-    wd->wh_hash_f = (wh_list**) calloc(wd->n_sds_p_f*HASH_SIZE, sizeof(wh_list*));
-    p_orbitals = (int*) malloc(sizeof(int)*wd->n_proton_f);
-    n_orbitals = (int*) malloc(sizeof(int)*wd->n_neutron_f);
-    int pp0 = gsl_sf_choose(wd->n_shells, wd->n_proton_f);
-    int pn0 = gsl_sf_choose(wd->n_shells, wd->n_neutron_f);
-    for (int i = 0; i < wd->n_states_f; i++) {
-    if (i % 1000000 == 0) {printf("%d\n", i);}
-    int in = 0;
-    int ip = 0;
-    unsigned int pp = pp0;
-    unsigned int pn = pn0;
-  //  printf("New state\n");
-    for (int j = 0; j < wd->n_data; j++) {
-      int i_state;
-      fread(&i_state, sizeof(int), 1, in_file);
- //     printf("%d\n", i_state);
-      if (i_state <= wd->n_shells) {
- //       p_orbitals[ip] = i_state;
-        pp -= n_choose_k(wd->n_shells - i_state, wd->n_proton_f - ip);
-        ip++;
-      } else {
- //       n_orbitals[in] = i_state - wd->n_shells;
-        pn -= n_choose_k(2*(wd->n_shells) - i_state, wd->n_neutron_f - in);
-        in++;
-      }
-    }
-
-    //  unsigned int pp = p_step(wd->n_shells, wd->n_proton_f, p_orbitals);
-    //  unsigned int pn = p_step(wd->n_shells, wd->n_neutron_f, n_orbitals);
-      unsigned int p_hash = pp + wd->n_sds_p_f*(pn % HASH_SIZE);
-      if (wd->wh_hash_f[p_hash] == NULL) {
-        wd->wh_hash_f[p_hash] = create_wh_node(pp, pn, i, NULL);
-      } else {
-        wh_append(wd->wh_hash_f[p_hash], pp, pn, i);
-      }
+    if (same_basis_file(basis_file_initial, basis_file_final, wd)) {
+      // Only the coefficients differ: share the basis index and build the jumps once
+      printf("Initial and final bases are identical, sharing the basis index\n");
+      wd->same_basis = 1;
+      wd->basis_f = wd->basis_i;
+    } else {
+      printf("Reading in final state basis\n");
+      wd->basis_f = read_basis_index(basis_file_final, wd, wd->n_proton_f, wd->n_neutron_f, wd->n_states_f, wd->n_sds_p_f, wd->n_sds_n_f, 0);
+      printf("Done.\n");
     }
-    printf("Done.\n");
-    free(p_orbitals);
-    free(n_orbitals);
-    fclose(in_file);
-
   }
+  wd->present_p_i = NULL;
+  wd->present_n_i = NULL;
+  wd->present_p_f = NULL;
+  wd->present_n_f = NULL;
+  if (BASIS_PRUNE_SDS) {mark_present_sds(wd);}
+  wd->renumbered = 0;
+  if (BASIS_RENUMBER) {renumber_basis_states(wd);}
 
   return wd;
 }
 
-sd_list* create_sd_node(unsigned int pi, unsigned int pn, int phase, sd_list* next) {
-  sd_list* new_node = (sd_list*)malloc(sizeof(sd_list));
-  if (new_node == NULL) {
-    printf("Error creating node\n");
-    exit(0);
+void mark_present_sds(wfnData *wd) {
+/* Finds the proton and neutron SDs used by the initial and final bases so the
+   jump builders can skip the ones a truncated basis leaves out
+*/
+  wd->present_p_i = (unsigned char*) calloc(wd->n_sds_p_i + 1, sizeof(unsigned char));
+  wd->present_n_i = (unsigned char*) calloc(wd->n_sds_n_i + 1, sizeof(unsigned char));
+  if ((wd->present_p_i == NULL) || (wd->present_n_i == NULL)) {printf("Error allocating SD masks\n"); exit(0);}
+  basis_present_sds(wd->basis_i, wd->present_p_i, wd->present_n_i);
+  if (wd->basis_f == wd->basis_i) {
+    wd->present_p_f = wd->present_p_i;
+    wd->present_n_f = wd->present_n_i;
+  } else {
+    wd->present_p_f = (unsigned char*) calloc(wd->n_sds_p_f + 1, sizeof(unsigned char));
+    wd->present_n_f = (unsigned char*) calloc(wd->n_sds_n_f + 1, sizeof(unsigned char));
+    if ((wd->present_p_f == NULL) || (wd->present_n_f == NULL)) {printf("Error allocating SD masks\n"); exit(0);}
+    basis_present_sds(wd->basis_f, wd->present_p_f, wd->present_n_f);
+  }
+  unsigned int n_p_i = 0, n_n_i = 0;
+  for (unsigned int p = 1; p <= wd->n_sds_p_i; p++) {n_p_i += wd->present_p_i[p];}
+  for (unsigned int p = 1; p <= wd->n_sds_n_i; p++) {n_n_i += wd->present_n_i[p];}
+  printf("Initial basis uses %u of %u proton SDs and %u of %u neutron SDs\n", n_p_i, wd->n_sds_p_i, n_n_i, wd->n_sds_n_i);
+  if (wd->basis_f != wd->basis_i) {
+    unsigned int n_p_f = 0, n_n_f = 0;
+    for (unsigned int p = 1; p <= wd->n_sds_p_f; p++) {n_p_f += wd->present_p_f[p];}
+    for (unsigned int p = 1; p <= wd->n_sds_n_f; p++) {n_n_f += wd->present_n_f[p];}
+    printf("Final basis uses %u of %u proton SDs and %u of %u neutron SDs\n", n_p_f, wd->n_sds_p_f, n_n_f, wd->n_sds_n_f);
   }
-  new_node->pi = pi;
-  new_node->pn = pn;
-  new_node->phase = phase;
-  new_node->next = next;
 
-  return new_node;
+  return;
 }
 
-
-sd_list* sd_append(sd_list* head, unsigned int pi, unsigned int pn, int phase) {
-  if (head->next == NULL) {
-    sd_list* new_node = create_sd_node(pi, pn, phase, NULL);
-    head->next = new_node;
+void renumber_basis_states(wfnData *wd) {
+/* Renumbers the initial and final bases for locality, permuting the coefficient
+   rows with them. A basis shared by both sides is renumbered once
+*/
+  if (wd->basis_f == wd->basis_i) {
+    if (wd->bc_f == wd->bc_i) {
+      wd->renumbered = basis_renumber(wd->basis_i, 1, &wd->bc_i, &wd->n_eig_i);
+      wd->bc_f = wd->bc_i;
+    } else {
+      float *bc[2] = {wd->bc_i, wd->bc_f};
+      int n_eig[2] = {wd->n_eig_i, wd->n_eig_f};
+      wd->renumbered = basis_renumber(wd->basis_i, 2, bc, n_eig);
+      wd->bc_i = bc[0];
+      wd->bc_f = bc[1];
+    }
   } else {
-    sd_list* next = head->next;
-    sd_list* new_node = create_sd_node(pi, pn, phase, next);
-    head->next = new_node;
+    wd->renumbered = basis_renumber(wd->basis_i, 1, &wd->bc_i, &wd->n_eig_i);
+    wd->renumbered &= basis_renumber(wd->basis_f, 1, &wd->bc_f, &wd->n_eig_f);
   }
+  if (!wd->renumbered) {printf("Basis renumbering needs the offset index, some states keep their BIGSTICK order\n");}
 
-  
-  return head;
+  return;
 }
 
-sde_list* create_sde_node(unsigned int pi, unsigned int pn, int phase, int n_quanta, sde_list* next) {
-  sde_list* new_node = (sde_list*)malloc(sizeof(sde_list));
-  if (new_node == NULL) {
-    printf("Error creating node\n");
+void check_basis_size(long long int n_states, int n_eig) {
+/* Stops if the coefficients of a basis cannot be addressed with basis_int
+   The 32-bit indices need n_states*n_eig below 2^31
+*/
+  if ((n_states < 0) || (n_eig < 0) || ((n_eig > 0) && (n_states > BASIS_INDEX_MAX/n_eig))) {
+    printf("Error: %lld basis states with %d eigenstates exceed the basis index range, set BASIS_INDEX_64 to 1 in glovar.h\n", n_states, n_eig);
     exit(0);
   }
-  new_node->pi = pi;
-  new_node->pn = pn;
-  new_node->phase = phase;
-  new_node->n_quanta = n_quanta;
-  new_node->next = next;
+  return;
+}
 
-  return new_node;
+int same_basis_file(char *basis_file_initial, char *basis_file_final, wfnData *wd) {
+/* Returns 1 if the initial and final .bas files describe the same basis,
+   comparing the wavefunction headers and then the two files byte by byte, from
+   the header through the last basis state
+*/
+  if ((wd->n_proton_i != wd->n_proton_f) || (wd->n_neutron_i != wd->n_neutron_f)) {return 0;}
+  if ((wd->n_states_i != wd->n_states_f) || (wd->jz_i != wd->jz_f) || (wd->parity_i != wd->parity_f) || (wd->wmax_i != wd->wmax_f)) {return 0;}
+  if (strcmp(basis_file_initial, basis_file_final) == 0) {return 1;}
+  int n_data = wd->n_proton_i + wd->n_neutron_i;
+  FILE *file_i = open_basis_file(basis_file_initial, wd->n_shells, NULL, NULL, NULL, NULL, NULL);
+  FILE *file_f = open_basis_file(basis_file_final, wd->n_shells, NULL, NULL, NULL, NULL, NULL);
+  long int states_offset = ftell(file_i);
+  int same = (ftell(file_f) == states_offset);
+  rewind(file_i);
+  rewind(file_f);
+  long long int n_left = states_offset + (long long int) sizeof(int)*n_data*wd->n_states_i;
+  unsigned char byte_i[4096], byte_f[4096];
+  while ((n_left > 0) && same) {
+    size_t n_want = MIN(n_left, (long long int) sizeof(byte_i));
+    if (fread(byte_i, 1, n_want, file_i) != n_want) {same = 0;}
+    if (fread(byte_f, 1, n_want, file_f) != n_want) {same = 0;}
+    if (same && (memcmp(byte_i, byte_f, n_want) != 0)) {same = 0;}
+    n_left -= n_want;
+  }
+  fclose(file_i);
+  fclose(file_f);
+
+  return same;
 }
 
-sde_list* sde_append(sde_list* head, unsigned int pi, unsigned int pn, int phase, int n_quanta) {
-  if (head->next == NULL) {
-    sde_list* new_node = create_sde_node(pi, pn, phase, n_quanta, NULL);
-    head->next = new_node;
-  } else {
-    sde_list* next = head->next;
-    sde_list* new_node = create_sde_node(pi, pn, phase, n_quanta, next);
-    head->next = new_node;
+FILE* open_basis_file(char *basis_file, int n_shells, int *n_shell, int *l_shell, int *j_shell, int *jz_shell, int *w_shell) {
+/* Opens a BIGSTICK .bas file and skips to the first basis state
+
+  Input(s):
+    char* basis_file: name of the .bas file
+    int n_shells: number of single-particle states per species
+    int* n_shell, l_shell, j_shell, jz_shell, w_shell: if not NULL, filled with the
+        single-particle quantum numbers stored in the file
+
+  Output(s):
+    FILE* in_file: file positioned at the occupation list of the first basis state
+*/
+  FILE *in_file = fopen(basis_file, "rb");
+  if (in_file == NULL) {printf("Error opening basis file %s\n", basis_file); exit(0);}
+  int junk, vec_offset;
+  fread(&junk, sizeof(int), 1, in_file);
+  fread(&junk, sizeof(int), 1, in_file);
+  fread(&junk, sizeof(int), 1, in_file);
+  fread(&vec_offset, sizeof(int), 1, in_file);
+  fseek(in_file, vec_offset + 16, SEEK_SET);
+  for (int i = 0; i < 2*n_shells; i++) {
+    int sps[6];
+    fread(sps, sizeof(int), 6, in_file);
+    if ((i < n_shells) && (n_shell != NULL)) {
+      n_shell[i] = sps[1];
+      l_shell[i] = sps[2];
+      j_shell[i] = sps[3];
+      jz_shell[i] = sps[4];
+      w_shell[i] = sps[5];
+    }
   }
 
-  
-  return head;
+  return in_file;
 }
 
+void decode_basis_state(int *orbitals, int n_shells, int n_proton, int n_neutron, unsigned int *pp, unsigned int *pn) {
+/* Converts the occupation list of a basis state into proton and neutron p-coefficients
+   Orbitals 1..n_shells are proton states, n_shells+1..2*n_shells neutron states
+*/
+  int in = 0;
+  int ip = 0;
+  *pp = n_choose_k(n_shells, n_proton);
+  *pn = n_choose_k(n_shells, n_neutron);
+  for (int j = 0; j < n_proton + n_neutron; j++) {
+    int i_state = orbitals[j];
+    if (i_state <= n_shells) {
+      *pp -= n_choose_k(n_shells - i_state, n_proton - ip);
+      ip++;
+    } else {
+      *pn -= n_choose_k(2*n_shells - i_state, n_neutron - in);
+      in++;
+    }
+  }
+  return;
+}
 
-wf_list* create_wf_node(unsigned int p, wf_list* next) {
-  wf_list* new_node = (wf_list*)malloc(sizeof(wf_list));
-  if (new_node == NULL) {
-    printf("Error creating node\n");
-    exit(0);
+void read_basis_file(char *basis_file, int n_shells, int n_proton, int n_neutron, long long int n_states, unsigned int *pp_state, unsigned int *pn_state, int *n_shell, int *l_shell, int *j_shell, int *jz_shell, int *w_shell) {
+/* Reads every basis state of a BIGSTICK .bas file
+
+  Output(s):
+    unsigned int* pp_state, pn_state: proton and neutron p-coefficient of each state
+*/
+  FILE *in_file = open_basis_file(basis_file, n_shells, n_shell, l_shell, j_shell, jz_shell, w_shell);
+  int *orbitals = (int*) malloc(sizeof(int)*(n_proton + n_neutron));
+  for (long long int i = 0; i < n_states; i++) {
+    if (i % 1000000 == 0) {printf("%lld\n", i);}
+    fread(orbitals, sizeof(int), n_proton + n_neutron, in_file);
+    decode_basis_state(orbitals, n_shells, n_proton, n_neutron, &pp_state[i], &pn_state[i]);
   }
-  new_node->p = p;
-  new_node->next = next;
-  
-  return new_node;
+  free(orbitals);
+  fclose(in_file);
+
+  return;
 }
 
-wf_list* wf_append(wf_list* head, unsigned int p) {
-  if (head->next == NULL) {
-    wf_list* new_node = create_wf_node(p, NULL);
-    head->next = new_node;
+static uint64_t basis_check_random(uint64_t *seed) {
+  // splitmix64 step, the spot checks keep their own generator and leave rand() alone
+  uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+wh_offsets* read_basis_offsets(char *basis_file, wfnData *wd, int n_proton, int n_neutron, long long int n_states, unsigned int n_sds_p, unsigned int n_sds_n, int read_shells) {
+/* Rebuilds the proton-block offset index without decoding every basis state
+   The basis is walked block by block: the first block of each neutron sector is
+   read in full to fix the ranks of its SDs, later blocks of the same sector are
+   only checked at their first and last state. A random sample of states is then
+   compared against the index
+
+  Output(s):
+    wh_offsets* offsets: the index, or NULL if the basis does not have the
+                         expected block structure
+*/
+  int ns = wd->n_shells;
+  FILE *in_file;
+  if (read_shells) {
+    in_file = open_basis_file(basis_file, ns, wd->n_shell, wd->l_shell, wd->j_shell, wd->jz_shell, wd->w_shell);
   } else {
-    wf_list* next = head->next;
-    wf_list* new_node = create_wf_node(p, next);
-    head->next = new_node;
+    in_file = open_basis_file(basis_file, ns, NULL, NULL, NULL, NULL, NULL);
+  }
+  long int states_offset = ftell(in_file);
+  int n_data = n_proton + n_neutron;
+  int *orbitals = (int*) malloc(sizeof(int)*n_data);
+  wh_offsets *offsets = wh_offsets_alloc(n_sds_p, n_sds_n);
+  long long int next_state = 0;
+  long long int n_read = 0;
+  long long int n_blocks = 0;
+  int valid = 1;
+
+  long long int start = 0;
+  while ((start < n_states) && valid) {
+    unsigned int pp, pn;
+    if (!read_basis_state(in_file, states_offset, &next_state, start, orbitals, n_data)) {valid = 0; break;}
+    n_read++;
+    decode_basis_state(orbitals, ns, n_proton, n_neutron, &pp, &pn);
+    int sector = wh_offsets_sector(offsets, pn, ns, n_neutron, wd->jz_shell, wd->l_shell, wd->w_shell);
+    if (sector < 0) {valid = 0; break;}
+    long long int end = start;
+    if (offsets->sector_size[sector] == 0) {
+      // First block of this sector: read it state by state
+      while (1) {
+        if (offsets->rank_n[pn] != UINT32_MAX) {valid = 0; break;}
+        offsets->rank_n[pn] = end - start;
+        end++;
+        if (end == n_states) {break;}
+        unsigned int pp_next;
+        if (!read_basis_state(in_file, states_offset, &next_state, end, orbitals, n_data)) {valid = 0; break;}
+        n_read++;
+        decode_basis_state(orbitals, ns, n_proton, n_neutron, &pp_next, &pn);
+        if (pp_next != pp) {break;}
+        int sector_next = wh_offsets_sector(offsets, pn, ns, n_neutron, wd->jz_shell, wd->l_shell, wd->w_shell);
+        if (sector_next < 0) {valid = 0; break;}
+        if (sector_next != sector) {break;}
+      }
+      offsets->sector_size[sector] = end - start;
+    } else {
+      // Later block: it must run from the first to the last SD of the sector
+      end = start + offsets->sector_size[sector];
+      if ((end > n_states) || (offsets->rank_n[pn] != 0)) {valid = 0; break;}
+      unsigned int pp_last, pn_last;
+      if (!read_basis_state(in_file, states_offset, &next_state, end - 1, orbitals, n_data)) {valid = 0; break;}
+      n_read++;
+      decode_basis_state(orbitals, ns, n_proton, n_neutron, &pp_last, &pn_last);
+      if ((pp_last != pp) || (offsets->sector_n[pn_last] != sector + 1) || (offsets->rank_n[pn_last] != end - 1 - start)) {valid = 0; break;}
+    }
+    if (!valid) {break;}
+    long long int *base = &offsets->base[(long long int) sector*(n_sds_p + 1) + pp];
+    if (*base >= 0) {valid = 0; break;}
+    *base = start;
+    n_blocks++;
+    start = end;
   }
 
-  return head;
+  // Spot check random states against the rebuilt index
+  uint64_t seed = BASIS_CHECK_SEED;
+  for (int k = 0; (k <= BASIS_CHECK_SAMPLES) && valid; k++) {
+    long long int i = (k == 0) ? n_states - 1 : (long long int) (basis_check_random(&seed) % (uint64_t) n_states);
+    unsigned int pp, pn;
+    if (!read_basis_state(in_file, states_offset, &next_state, i, orbitals, n_data)) {valid = 0; break;}
+    decode_basis_state(orbitals, ns, n_proton, n_neutron, &pp, &pn);
+    if ((pp > n_sds_p) || (pn > n_sds_n) || (wh_offsets_lookup(offsets, pp, pn) != i)) {valid = 0;}
+  }
+  free(orbitals);
+  fclose(in_file);
+  if (!valid) {
+    wh_offsets_free(offsets);
+    return NULL;
+  }
+  printf("Rebuilt basis index from %lld blocks, decoded %lld of %lld states\n", n_blocks, n_read, n_states);
+  printf("Offset index: %d neutron sectors, %g MB\n", offsets->n_sectors, wh_offsets_memory(offsets));
+
+  return offsets;
 }
 
-wfe_list* create_wfe_node(unsigned int p, int n_quanta, wfe_list* next) {
-  wfe_list* new_node = (wfe_list*)malloc(sizeof(wfe_list));
-  if (new_node == NULL) {
-    printf("Error creating node\n");
-    exit(0);
-  }
-  new_node->p = p;
-  new_node->n_quanta = n_quanta;
-  new_node->next = next;
-  
-  return new_node;
+int read_basis_state(FILE *in_file, long int states_offset, long long int *next_state, long long int i, int *orbitals, int n_data) {
+/* Reads the occupation list of basis state i, seeking only if it is not the next
+   state in the file. Returns 0 on a short read
+*/
+  if (i != *next_state) {fseek(in_file, states_offset + (long int) sizeof(int)*n_data*i, SEEK_SET);}
+  if (fread(orbitals, sizeof(int), n_data, in_file) != n_data) {return 0;}
+  *next_state = i + 1;
+  return 1;
 }
 
-wfe_list* wfe_append(wfe_list* head, unsigned int p, int n_quanta) {
-  if (head->next == NULL) {
-    wfe_list* new_node = create_wfe_node(p, n_quanta, NULL);
-    head->next = new_node;
+basis_index* read_basis_index(char *basis_file, wfnData *wd, int n_proton, int n_neutron, long long int n_states, unsigned int n_sds_p, unsigned int n_sds_n, int read_shells) {
+/* Builds the index of one basis (initial or final)
+   The offset index is rebuilt from the block structure when possible,
+   otherwise every basis state is read and decoded
+*/
+  if ((BASIS_LOOKUP_MODE == BASIS_LOOKUP_OFFSET) && BASIS_FAST_LOAD) {
+    wh_offsets *offsets = read_basis_offsets(basis_file, wd, n_proton, n_neutron, n_states, n_sds_p, n_sds_n, read_shells);
+    if (offsets != NULL) {
+      return basis_index_from_offsets(offsets);
+    }
+    printf("Basis does not match its block structure, reading every state\n");
+  }
+  unsigned int *pp_state = (unsigned int*) malloc(sizeof(unsigned int)*n_states);
+  unsigned int *pn_state = (unsigned int*) malloc(sizeof(unsigned int)*n_states);
+  if (read_shells) {
+    read_basis_file(basis_file, wd->n_shells, n_proton, n_neutron, n_states, pp_state, pn_state, wd->n_shell, wd->l_shell, wd->j_shell, wd->jz_shell, wd->w_shell);
   } else {
-    wfe_list* next = head->next;
-    wfe_list* new_node = create_wfe_node(p, n_quanta, next);
-    head->next = new_node;
+    read_basis_file(basis_file, wd->n_shells, n_proton, n_neutron, n_states, pp_state, pn_state, NULL, NULL, NULL, NULL, NULL);
   }
+  basis_index *basis = basis_index_create(n_states, pp_state, pn_state, n_sds_p, n_sds_n, wd->n_shells, n_neutron, wd->jz_shell, wd->l_shell, wd->w_shell, BASIS_LOOKUP_MODE);
+  free(pp_state);
+  free(pn_state);
 
-  return head;
+  return basis;
 }
 
+void report_lookup_stats(wfnData *wd) {
+  // Prints the lookups rejected by the basis filters and the reuse of resolved jump tables
+  basis_filter_report(wd->basis_i, "Initial");
+  if (wd->basis_f != wd->basis_i) {basis_filter_report(wd->basis_f, "Final");}
+  resolved_cache_report(wd->jumps);
+  return;
+}
 
-wh_list* create_wh_node(unsigned int pp, unsigned int pn, unsigned int index, wh_list* next) {
+wh_list* create_wh_node(unsigned int pp, unsigned int pn, basis_int index, wh_list* next) {
   wh_list* new_node = (wh_list*)malloc(sizeof(wh_list));
   if (new_node == NULL) {
     printf("Error creating node\n");
@@ -547,7 +662,7 @@ wh_list* create_wh_node(unsigned int pp, unsigned int pn, unsigned int index, wh
   return new_node;
 }
 
-wh_list* wh_append(wh_list* head, unsigned int pp, unsigned int pn, unsigned int index) {
+wh_list* wh_append(wh_list* head, unsigned int pp, unsigned int pn, basis_int index) {
   if (head->next == NULL) {
     wh_list* new_node = create_wh_node(pp, pn, index, NULL);
     head->next = new_node;
@@ -586,6 +701,52 @@ eigen_list* eigen_append(eigen_list* head, int eig_i, int eig_f) {
   return head;
 }
 
+void eigen_list_free(eigen_list* head) {
+  while (head != NULL) {
+    eigen_list *next = head->next;
+    free(head);
+    head = next;
+  }
+  return;
+}
+
+void wfn_data_free(wfnData *wd) {
+/* Releases the wavefunction data read by read_binary_wfn_data, including the
+   basis indices and resolved jump tables, so that runs can follow one another
+   in one process. Arrays the final state shares with the initial state are
+   released once
+*/
+  if (wd == NULL) {return;}
+  resolved_cache_free(wd->jumps);
+  if (wd->basis_f != wd->basis_i) {basis_index_free(wd->basis_f);}
+  basis_index_free(wd->basis_i);
+  if (wd->present_p_f != wd->present_p_i) {free(wd->present_p_f);}
+  if (wd->present_n_f != wd->present_n_i) {free(wd->present_n_f);}
+  free(wd->present_p_i);
+  free(wd->present_n_i);
+  if (wd->bc_f != wd->bc_i) {free(wd->bc_f);}
+  free(wd->bc_i);
+  if (wd->e_nuc_f != wd->e_nuc_i) {
+    free(wd->e_nuc_f);
+    free(wd->j_nuc_f);
+    free(wd->t_nuc_f);
+  }
+  free(wd->e_nuc_i);
+  free(wd->j_nuc_i);
+  free(wd->t_nuc_i);
+  free(wd->n_shell);
+  free(wd->l_shell);
+  free(wd->j_shell);
+  free(wd->jz_shell);
+  free(wd->w_shell);
+  free(wd->n_orb);
+  free(wd->l_orb);
+  free(wd->w_orb);
+  free(wd->j_orb);
+  free(wd);
+  return;
+}
+
 
 /* Deprecated code
 
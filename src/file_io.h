@@ -1,6 +1,6 @@
 #ifndef FILE_IO_H
 #define FILE_IO_H
-#include "slater.h"
+#include "jumps.h"
 
 typedef struct eigen_list
 {
@@ -14,41 +14,11 @@ typedef struct sBasisCoeff
   double *wave;
 } BasisCoeff;
 
-typedef struct sd_list
-{
-  int pi, pn;
-  int phase;
-  struct sd_list *next;
-} sd_list;
-
-typedef struct sde_list
-{
-  int pi, pn;
-  int phase;
-  int n_quanta;
-  struct sde_list *next;
-} sde_list;
-
-
-typedef struct wf_list
-{
-  unsigned int p;
-  struct wf_list *next;
-} wf_list;
-
-typedef struct wfe_list
-{
-  unsigned int p;
-  int n_quanta;
-  struct wfe_list *next;
-} wfe_list;
-
-
 typedef struct wh_list
 {
   unsigned int pn;
   unsigned int pp;
-  unsigned int index;
+  basis_int index;
   struct wh_list *next;
 } wh_list;
 
@@ -60,7 +30,11 @@ typedef struct wfnData
   int n_eig_i, n_eig_f;
   int parity_i, wmax_i, parity_f, wmax_f;
   unsigned int n_sds_p_i, n_sds_p_f, n_sds_n_i, n_sds_n_f;
-  wh_list **wh_hash_i, **wh_hash_f;
+  basis_index *basis_i, *basis_f;
+  resolved_cache *jumps; // resolved jump tables, NULL if disabled
+  int join_a20, join_a22; // resolve a20/a22 lookups by merge-join instead of per-pair lookups
+  int renumbered; // 1 if the basis states were renumbered for locality
+  unsigned char *present_p_i, *present_n_i, *present_p_f, *present_n_f; // SDs occurring in each basis, NULL if not pruned
   float *bc_i, *bc_f;
   int *n_shell, *l_shell, *j_shell, *jz_shell, *tz_shell, *w_shell;
   int *n_orb, *l_orb, *w_orb;
@@ -81,19 +55,25 @@ typedef struct speedParams
   
 } speedParams;
 
-sd_list* create_sd_node(unsigned int pi, unsigned int pf, int phase, sd_list* next);
-sd_list* sd_append(sd_list* head, unsigned int pi, unsigned int pf, int phase);
-sde_list* create_sde_node(unsigned int pi, unsigned int pf, int phase, int n_quanta, sde_list* next);
-sde_list* sde_append(sde_list* head, unsigned int pi, unsigned int pf, int phase, int n_quanta);
-wf_list* create_wf_node(unsigned int b, wf_list* next);
-wf_list* wf_append(wf_list* head, unsigned int p);
-wfe_list* create_wfe_node(unsigned int b, int n_quanta, wfe_list* next);
-wfe_list* wfe_append(wfe_list* head, unsigned int p, int n_quanta);
-wh_list* create_wh_node(unsigned int pp, unsigned int pn, unsigned int index, wh_list* next);
-wh_list* wh_append(wh_list* head, unsigned int pp, unsigned int pn, unsigned int index);
+wh_list* create_wh_node(unsigned int pp, unsigned int pn, basis_int index, wh_list* next);
+wh_list* wh_append(wh_list* head, unsigned int pp, unsigned int pn, basis_int index);
 eigen_list* create_eigen_node(int eig_i, int eig_n, eigen_list* next);
 eigen_list* eigen_append(eigen_list* head, int eig_i, int eig_f);
+void eigen_list_free(eigen_list* head);
+void speed_params_free(speedParams *sp);
+void wfn_data_free(wfnData *wd);
 wfnData* read_wfn_data(char *wfn_file_initial, char *wfn_file_final, char *orbit_file);
+FILE* open_basis_file(char *basis_file, int n_shells, int *n_shell, int *l_shell, int *j_shell, int *jz_shell, int *w_shell);
+void decode_basis_state(int *orbitals, int n_shells, int n_proton, int n_neutron, unsigned int *pp, unsigned int *pn);
+int read_basis_state(FILE *in_file, long int states_offset, long long int *next_state, long long int i, int *orbitals, int n_data);
+void read_basis_file(char *basis_file, int n_shells, int n_proton, int n_neutron, long long int n_states, unsigned int *pp_state, unsigned int *pn_state, int *n_shell, int *l_shell, int *j_shell, int *jz_shell, int *w_shell);
+wh_offsets* read_basis_offsets(char *basis_file, wfnData *wd, int n_proton, int n_neutron, long long int n_states, unsigned int n_sds_p, unsigned int n_sds_n, int read_shells);
+basis_index* read_basis_index(char *basis_file, wfnData *wd, int n_proton, int n_neutron, long long int n_states, unsigned int n_sds_p, unsigned int n_sds_n, int read_shells);
+void report_lookup_stats(wfnData *wd);
+void mark_present_sds(wfnData *wd);
+void renumber_basis_states(wfnData *wd);
+void check_basis_size(long long int n_states, int n_eig);
+int same_basis_file(char *basis_file_initial, char *basis_file_final, wfnData *wd);
 wfnData* read_binary_wfn_data(char *wfn_file_initial, char *wfn_file_final, char* basis_file_initial, char *basis_file_final);
 speedParams* read_parameter_file(char* parameter_file);
 #endif
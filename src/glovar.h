@@ -2,11 +2,59 @@
 #include "math.h"
 #include "stdlib.h"
 #include "stdint.h"
+#include "limits.h"
 #include "string.h"
 #include "time.h"
 #include <gsl/gsl_sf.h>
 
 #define HASH_SIZE 9781
+// Target fraction of occupied slots in the open-addressing basis index
+#define WH_LOAD_FACTOR 0.7
+// Basis lookups: 0 = open-addressing hash, 1 = proton-block offsets (falls back to the hash)
+#define BASIS_LOOKUP_MODE 1
+// Rebuild the offset index from the block structure of the .bas file instead of decoding
+// every state, spot checking BASIS_CHECK_SAMPLES random states (0 = always decode all states)
+#define BASIS_FAST_LOAD 1
+#define BASIS_CHECK_SAMPLES 1000
+#define BASIS_CHECK_SEED 2718
+// Reject lookups of states outside a hashed basis with a (proton SD, neutron sector) bitmap
+#define BASIS_FILTER 1
+// Count the lookups the filter rejects and report them after each run (stats build, slows every lookup)
+#define BASIS_FILTER_STATS 0
+// Resolve the basis lookups of trace_a20_nodes / trace_a22_nodes in sorted batches (merge-join)
+#define MERGE_JOIN_A20 0
+#define MERGE_JOIN_A22 0
+// Most lookups a merge-join collects before resolving them (about 44 bytes each)
+#define MERGE_JOIN_BATCH (1 << 18)
+// Resolve each operator's jump lists once into (index_i, index_f, phase) tables and reuse them
+#define RESOLVED_JUMPS 0
+// Memory cap for resolved tables in MB, beyond which they are spilled (1) to a scratch file or dropped (0)
+#define RESOLVED_JUMP_MAX_MB 1024
+#define RESOLVED_JUMP_SPILL 1
+// Renumber basis states and coefficient rows in proton SD order when the offset index is available
+#define BASIS_RENUMBER 0
+// Basis state indices: 0 = 32-bit, for bases with n_states*n_eig below 2^31, 1 = 64-bit
+#define BASIS_INDEX_64 0
+// Act annihilation operators in the jump builders on occupation masks, for up to SD_MASK_BITS orbitals
+#define SD_MASK_OPS 1
+// Skip SDs that do not occur in the basis when building jump lists
+#define BASIS_PRUNE_SDS 1
+// Trace same-species one-body operators from direct a+a jump lists instead of a jump to an intermediate SD and back
+#define ONE_BODY_HOPS 0
+// Two-body traces compose a(c) a(d) from the one-body jump lists instead of storing two-body lists
+#define TWO_BODY_COMPOSE 0
+// Storage of the maps from intermediate SDs back to final SDs: 0 = dense arrays, 1 = sorted runs, 2 = rebuilt on each lookup
+#define REV_MAP_MODE 0
+// Dense maps larger than this, in MB, are stored as sorted runs
+#define REV_MAP_DENSE_MAX_MB 512
+// Store jump tables as delta/varint byte streams, decoded on the fly in the traces
+#define JUMP_COMPRESS 0
+// Size in MB of the blocks the jump tables of a run are carved from
+#define ARENA_BLOCK_MB 16
+// Chunks per thread the SDs of a jump builder are split into, several to even out the load
+#define JUMP_BUILD_CHUNKS 4
+// Builders walking fewer SDs than this run in a single chunk
+#define JUMP_BUILD_MIN_SDS 4096
 
 // FILE SETUP
 #define DENSITY_FILE "ne-mg_fermi_density"
@@ -14,6 +62,11 @@
 #define WFN_FILE_FINAL "mg20_basis.trwfn"
 #define ORBIT_FILE "sd.sps"
 
+// BENCHMARKS
+#define BENCH_LOOKUPS 10000000
+#define BENCH_SEED 12345
+#define BENCH_DECODES 1000000
+
 #define MIN(a,b) ((a) < (b) ? (a):(b))
 #define MAX(a,b) ((a) > (b) ? (a):(b))
 
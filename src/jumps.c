@@ -0,0 +1,295 @@
+#include "jumps.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static void* jump_alloc(jump_table* table, size_t bytes) {
+  void *p = (table->pool != NULL) ? arena_alloc(table->pool, bytes) : malloc(bytes);
+  if (p == NULL) {printf("Error allocating jump table\n"); exit(0);}
+  return p;
+}
+
+static void* jump_calloc(jump_table* table, size_t bytes) {
+  void *p = jump_alloc(table, bytes);
+  memset(p, 0, bytes);
+  return p;
+}
+
+static void jump_release(jump_table* table, void* p) {
+  // Arena storage is only released with its arena
+  if (table->pool == NULL) {free(p);}
+}
+
+jump_table* jump_table_create(size_t n_rows, int with_pn, int with_quanta) {
+  return jump_table_create_in(NULL, n_rows, with_pn, with_quanta);
+}
+
+jump_table* jump_table_create_in(arena* pool, size_t n_rows, int with_pn, int with_quanta) {
+/* Allocate an empty jump table, ready for the counting pass of a builder
+
+  Input(s):
+    arena* pool: arena to take the storage from, NULL to malloc it
+    size_t n_rows: number of (parity, mj, orbital(s)) slots
+    int with_pn: 1 for a1/a2 tables holding (pi, pn, phase), 0 for a0 tables holding pi
+    int with_quanta: 1 to also store the spectator quanta of each entry
+
+  Output(s):
+    jump_table* table: the table, to be filled with jump_table_add and closed with jump_table_finish
+*/
+  jump_table *table = (pool != NULL) ? arena_alloc(pool, sizeof(*table)) : malloc(sizeof(*table));
+  if (table == NULL) {printf("Error allocating jump table\n"); exit(0);}
+  table->pool = pool;
+  table->n_rows = n_rows;
+  table->start = (size_t*) jump_calloc(table, sizeof(size_t)*(n_rows + 1));
+  table->fill = NULL;
+  table->pi = NULL;
+  table->pn = NULL;
+  table->phase = NULL;
+  table->n_quanta = NULL;
+  table->with_pn = with_pn;
+  table->with_quanta = with_quanta;
+  table->compressed = 0;
+  table->byte_start = NULL;
+  table->last_pi = NULL;
+  table->stream = NULL;
+  jump_table_set_compressed(table, JUMP_COMPRESS);
+
+  return table;
+}
+
+void jump_table_set_compressed(jump_table* table, int compressed) {
+/* Chooses the storage of a table before its counting pass
+
+  Input(s):
+    jump_table* table: an empty table from jump_table_create
+    int compressed: 1 for delta/varint byte streams, 0 for packed arrays
+*/
+  if ((table->fill != NULL) || (table->start[table->n_rows] != 0)) {printf("Error: jump table storage changed after counting\n"); exit(0);}
+  if (table->compressed == compressed) {return;}
+  jump_release(table, table->byte_start);
+  jump_release(table, table->last_pi);
+  table->byte_start = NULL;
+  table->last_pi = NULL;
+  table->compressed = compressed;
+  if (!compressed) {return;}
+  table->byte_start = (size_t*) jump_calloc(table, sizeof(size_t)*(table->n_rows + 1));
+  table->last_pi = (unsigned int*) jump_calloc(table, sizeof(unsigned int)*MAX(table->n_rows, 1));
+  return;
+}
+
+void jump_table_add_compressed(jump_table* table, size_t row, unsigned int pi, unsigned int pn, int phase, int n_quanta) {
+  // jump_table_add for compressed tables: counts the bytes of an entry, or encodes it
+  uint64_t d_pi = jump_zigzag((int64_t) pi - (int64_t) table->last_pi[row]);
+  uint64_t d_pn = (jump_zigzag((int64_t) pn - (int64_t) pi) << 1) | (phase < 0);
+  uint64_t quanta = jump_zigzag(n_quanta);
+  table->last_pi[row] = pi;
+  if (table->fill == NULL) {
+    size_t n = jump_varint_size(d_pi);
+    if (table->with_pn) {n += jump_varint_size(d_pn);}
+    if (table->with_quanta) {n += jump_varint_size(quanta);}
+    table->start[row + 1]++;
+    table->byte_start[row + 1] += n;
+    return;
+  }
+  unsigned char *p = table->stream + table->fill[row];
+  p = jump_varint_put(p, d_pi);
+  if (table->with_pn) {p = jump_varint_put(p, d_pn);}
+  if (table->with_quanta) {p = jump_varint_put(p, quanta);}
+  table->fill[row] = p - table->stream;
+  return;
+}
+
+void jump_table_begin_fill(jump_table* table) {
+/* Ends the counting pass: turns the counts into row offsets and allocates the entries
+   Safe to call on NULL
+*/
+  if (table == NULL) {return;}
+  if (table->fill != NULL) {printf("Error: jump table is already being filled\n"); exit(0);}
+  for (size_t row = 0; row < table->n_rows; row++) {table->start[row + 1] += table->start[row];}
+  if (table->compressed) {
+    for (size_t row = 0; row < table->n_rows; row++) {
+      table->byte_start[row + 1] += table->byte_start[row];
+      table->last_pi[row] = 0;
+    }
+    table->fill = (size_t*) jump_alloc(table, sizeof(size_t)*MAX(table->n_rows, 1));
+    table->stream = (unsigned char*) jump_alloc(table, MAX(table->byte_start[table->n_rows], 1));
+    memcpy(table->fill, table->byte_start, sizeof(size_t)*table->n_rows);
+    return;
+  }
+  size_t n = MAX(table->start[table->n_rows], 1);
+  table->fill = (size_t*) jump_alloc(table, sizeof(size_t)*MAX(table->n_rows, 1));
+  table->pi = (unsigned int*) jump_alloc(table, sizeof(unsigned int)*n);
+  memcpy(table->fill, table->start, sizeof(size_t)*table->n_rows);
+  if (table->with_pn) {
+    table->pn = (unsigned int*) jump_alloc(table, sizeof(unsigned int)*n);
+    table->phase = (signed char*) jump_alloc(table, sizeof(signed char)*n);
+  }
+  if (table->with_quanta) {
+    table->n_quanta = (int*) jump_alloc(table, sizeof(int)*n);
+  }
+  return;
+}
+
+void jump_table_finish(jump_table* table) {
+  // Ends the filling pass, checking that it wrote what was counted, safe to call on NULL
+  if ((table == NULL) || (table->fill == NULL)) {return;}
+  const size_t *end = (table->compressed) ? table->byte_start : table->start;
+  for (size_t row = 0; row < table->n_rows; row++) {
+    if (table->fill[row] != end[row + 1]) {printf("Error: jump table filling does not match its count\n"); exit(0);}
+  }
+  jump_release(table, table->fill);
+  table->fill = NULL;
+  jump_release(table, table->last_pi);
+  table->last_pi = NULL;
+  return;
+}
+
+void jump_table_free(jump_table* table) {
+  if ((table == NULL) || (table->pool != NULL)) {return;}
+  free(table->start);
+  free(table->fill);
+  free(table->pi);
+  free(table->pn);
+  free(table->phase);
+  free(table->n_quanta);
+  free(table->byte_start);
+  free(table->last_pi);
+  free(table->stream);
+  free(table);
+  return;
+}
+
+double jump_table_memory(const jump_table* table) {
+  // Bytes held by a finished table
+  if (table == NULL) {return 0.0;}
+  double n = (double) table->start[table->n_rows];
+  if (table->compressed) {return 2.0*sizeof(size_t)*(double) (table->n_rows + 1) + (double) table->byte_start[table->n_rows];}
+  double bytes = sizeof(size_t)*(double) (table->n_rows + 1) + sizeof(unsigned int)*n;
+  if (table->with_pn) {bytes += (sizeof(unsigned int) + sizeof(signed char))*n;}
+  if (table->with_quanta) {bytes += sizeof(int)*n;}
+  return bytes;
+}
+
+double jump_table_estimate(size_t n_rows, double n_entries, int with_pn, int with_quanta) {
+  // Bytes a packed table of n_rows rows and n_entries entries would hold
+  double bytes = sizeof(size_t)*(double) (n_rows + 1) + sizeof(unsigned int)*n_entries;
+  if (with_pn) {bytes += (sizeof(unsigned int) + sizeof(signed char))*n_entries;}
+  if (with_quanta) {bytes += sizeof(int)*n_entries;}
+  return bytes;
+}
+
+void jump_split_start(jump_split* split, unsigned int n_sds, int parallel, jump_table* table0, jump_table* table1, jump_table* table2) {
+/* Splits the SDs 1..n_sds of a builder into chunks, one per JUMP_BUILD_CHUNKS-th of a
+   thread, and gives each chunk its own view of the tables for the counting pass
+   A single chunk is used without OpenMP, for small bases, when the caller cannot
+   run in parallel (parallel = 0) or for compressed tables, whose deltas run across
+   the whole row
+
+  Input(s):
+    unsigned int n_sds: number of SDs walked
+    int parallel: 0 if the builder also writes reverse maps that chunks cannot share
+    jump_table* table0, table1, table2: the tables the builder fills, or NULL
+*/
+  split->table[0] = table0;
+  split->table[1] = table1;
+  split->table[2] = table2;
+  int n_threads = 1;
+#ifdef _OPENMP
+  n_threads = omp_get_max_threads();
+#endif
+  int n_chunks = 1;
+  if (parallel && (n_threads > 1) && (n_sds >= JUMP_BUILD_MIN_SDS)) {n_chunks = n_threads*JUMP_BUILD_CHUNKS;}
+  for (int k = 0; k < JUMP_SPLIT_TABLES; k++) {
+    if ((split->table[k] != NULL) && split->table[k]->compressed) {n_chunks = 1;}
+  }
+  split->n_chunks = n_chunks;
+  split->first = (unsigned int*) malloc(sizeof(unsigned int)*(n_chunks + 1));
+  if (split->first == NULL) {printf("Error allocating jump split\n"); exit(0);}
+  for (int c = 0; c <= n_chunks; c++) {split->first[c] = 1 + (unsigned int) ((uint64_t) n_sds*c/n_chunks);}
+  split->view = NULL;
+  if (n_chunks == 1) {return;}
+
+  split->view = (jump_table*) malloc(sizeof(jump_table)*n_chunks*JUMP_SPLIT_TABLES);
+  if (split->view == NULL) {printf("Error allocating jump split\n"); exit(0);}
+  for (int k = 0; k < JUMP_SPLIT_TABLES; k++) {
+    if (split->table[k] == NULL) {continue;}
+    for (int c = 0; c < n_chunks; c++) {
+      jump_table *view = &split->view[c + n_chunks*k];
+      *view = *split->table[k];
+      view->pool = NULL;
+      view->start = (size_t*) calloc(view->n_rows + 1, sizeof(size_t));
+      if (view->start == NULL) {printf("Error allocating jump split\n"); exit(0);}
+    }
+  }
+
+  return;
+}
+
+void jump_split_begin_fill(jump_split* split) {
+  // Ends the counting pass: sizes the tables from the counts of all chunks and points each view at its slice of every row
+  int n_chunks = split->n_chunks;
+  for (int k = 0; k < JUMP_SPLIT_TABLES; k++) {
+    jump_table *table = split->table[k];
+    if (table == NULL) {continue;}
+    if (n_chunks == 1) {
+      jump_table_begin_fill(table);
+      continue;
+    }
+    for (size_t row = 0; row < table->n_rows; row++) {
+      size_t n = 0;
+      for (int c = 0; c < n_chunks; c++) {n += split->view[c + n_chunks*k].start[row + 1];}
+      table->start[row + 1] = n;
+    }
+    jump_table_begin_fill(table);
+    for (int c = 0; c < n_chunks; c++) {
+      jump_table *view = &split->view[c + n_chunks*k];
+      view->fill = (size_t*) malloc(sizeof(size_t)*MAX(view->n_rows, 1));
+      if (view->fill == NULL) {printf("Error allocating jump split\n"); exit(0);}
+      view->pi = table->pi;
+      view->pn = table->pn;
+      view->phase = table->phase;
+      view->n_quanta = table->n_quanta;
+    }
+    for (size_t row = 0; row < table->n_rows; row++) {
+      size_t offset = table->start[row];
+      for (int c = 0; c < n_chunks; c++) {
+        jump_table *view = &split->view[c + n_chunks*k];
+        view->fill[row] = offset;
+        offset += view->start[row + 1];
+      }
+    }
+  }
+
+  return;
+}
+
+void jump_split_finish(jump_split* split) {
+  // Ends the filling pass, checking that each chunk wrote what it counted, and releases the views
+  int n_chunks = split->n_chunks;
+  for (int k = 0; k < JUMP_SPLIT_TABLES; k++) {
+    jump_table *table = split->table[k];
+    if (table == NULL) {continue;}
+    if (n_chunks > 1) {
+      for (size_t row = 0; row < table->n_rows; row++) {
+        size_t offset = table->start[row];
+        for (int c = 0; c < n_chunks; c++) {
+          jump_table *view = &split->view[c + n_chunks*k];
+          offset += view->start[row + 1];
+          if (view->fill[row] != offset) {printf("Error: jump table filling does not match its count\n"); exit(0);}
+        }
+        table->fill[row] = offset;
+      }
+      for (int c = 0; c < n_chunks; c++) {
+        free(split->view[c + n_chunks*k].start);
+        free(split->view[c + n_chunks*k].fill);
+      }
+    }
+    jump_table_finish(table);
+  }
+  free(split->view);
+  free(split->first);
+  split->view = NULL;
+  split->first = NULL;
+
+  return;
+}
@@ -0,0 +1,175 @@
+#ifndef JUMPS_H
+#define JUMPS_H
+#include "arena.h"
+
+/* Jump tables
+   The jumps of one family (a0, a1 or a2 jumps of a species, initial or final) are
+   stored in compressed sparse row form: row r is the (parity, mj, orbital(s)) slot
+   of the family, indexed as the jump lists were, and its entries are
+   [start[r], start[r + 1]) of packed arrays of (pi, pn, phase).
+   Builders walk their SDs twice, counting the entries of each row with
+   jump_table_add, then, after jump_table_begin_fill, writing them with the same
+   calls. Entries of a row keep the order of the walk, increasing in the SD the
+   builder walks, so the coefficient gathers of the traces run forward
+
+   Compressed tables (JUMP_COMPRESS) keep the same rows but store each entry as
+   varints in a byte stream: pi as the zigzag difference from the previous pi of
+   the row, pn as the zigzag difference from pi shifted up one bit with the sign
+   of the phase in the low bit, and the spectator quanta. Traces read both forms
+   through a jump_cursor
+
+   Tables created in an arena take all their storage from it: jump_table_free
+   leaves them alone and they go when the arena is freed
+
+   Builders split their SDs into contiguous chunks walked in parallel (jump_split).
+   Each chunk counts and then writes its entries through a view of every table,
+   whose write cursors start where the entries of the previous chunks end in each
+   row, so the tables come out identical to a serial walk
+*/
+
+typedef struct jump_table
+{
+  size_t n_rows;
+  size_t *start; // n_rows + 1 offsets, entry counts shifted by one row while counting
+  size_t *fill; // write cursor of each row while filling, NULL while counting and once finished
+  unsigned int *pi; // SD the jump starts from, the only field of a0 tables
+  unsigned int *pn; // SD reached by the jump, NULL in a0 tables
+  signed char *phase; // NULL in a0 tables
+  int *n_quanta; // oscillator quanta of the spectators, NULL outside spectator mode
+  int with_pn, with_quanta;
+  int compressed; // entries are in stream, pi/pn/phase/n_quanta stay NULL
+  size_t *byte_start; // n_rows + 1 byte offsets of the rows in stream, fill then runs over bytes
+  unsigned int *last_pi; // previous pi of each row while building a compressed table
+  unsigned char *stream;
+  arena *pool; // arena holding the table, NULL if it is malloc'd
+} jump_table;
+
+// Most tables a builder fills at once
+#define JUMP_SPLIT_TABLES 3
+
+typedef struct jump_split
+{
+  int n_chunks;
+  unsigned int *first; // chunk c walks the SDs with first[c] <= p < first[c + 1]
+  jump_table *table[JUMP_SPLIT_TABLES];
+  jump_table *view; // view of table k for chunk c at view[c + n_chunks*k], NULL for a single chunk
+} jump_split;
+
+typedef struct jump_cursor
+{
+  const jump_table *table;
+  size_t k, end;
+  const unsigned char *p; // NULL when reading the packed arrays
+  unsigned int pi, pn;
+  int phase, n_quanta;
+} jump_cursor;
+
+jump_table* jump_table_create(size_t n_rows, int with_pn, int with_quanta);
+jump_table* jump_table_create_in(arena* pool, size_t n_rows, int with_pn, int with_quanta);
+void jump_table_set_compressed(jump_table* table, int compressed);
+void jump_table_begin_fill(jump_table* table);
+void jump_table_finish(jump_table* table);
+void jump_table_free(jump_table* table);
+double jump_table_memory(const jump_table* table);
+double jump_table_estimate(size_t n_rows, double n_entries, int with_pn, int with_quanta);
+void jump_table_add_compressed(jump_table* table, size_t row, unsigned int pi, unsigned int pn, int phase, int n_quanta);
+
+/* A builder calls jump_split_start, walks the SDs of every chunk once to count its
+   jumps, calls jump_split_begin_fill, walks them again to store them through the
+   same views and ends with jump_split_finish. Builders that only fill tables let
+   their chunks run in parallel (parallel = 1), those that also set reverse maps
+   pass rev_map_parallel of the maps, as only dense maps take writes from several
+   chunks
+*/
+void jump_split_start(jump_split* split, unsigned int n_sds, int parallel, jump_table* table0, jump_table* table1, jump_table* table2);
+void jump_split_begin_fill(jump_split* split);
+void jump_split_finish(jump_split* split);
+
+static inline jump_table* jump_split_view(const jump_split* split, int k, int c) {
+  // Table k as seen by chunk c, NULL if the builder has no such table
+  if ((split->table[k] == NULL) || (split->view == NULL)) {return split->table[k];}
+  return &split->view[c + split->n_chunks*k];
+}
+
+static inline uint64_t jump_zigzag(int64_t d) {return ((uint64_t) d << 1) ^ (uint64_t) (d >> 63);}
+
+static inline int64_t jump_unzigzag(uint64_t v) {return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);}
+
+static inline int jump_varint_size(uint64_t v) {
+  int n = 1;
+  while (v >= 0x80) {v >>= 7; n++;}
+  return n;
+}
+
+static inline unsigned char* jump_varint_put(unsigned char* p, uint64_t v) {
+  while (v >= 0x80) {*p++ = (unsigned char) (v | 0x80); v >>= 7;}
+  *p++ = (unsigned char) v;
+  return p;
+}
+
+static inline const unsigned char* jump_varint_get(const unsigned char* p, uint64_t* v) {
+  uint64_t x = *p & 0x7f;
+  int shift = 7;
+  while (*p++ & 0x80) {x |= (uint64_t) (*p & 0x7f) << shift; shift += 7;}
+  *v = x;
+  return p;
+}
+
+static inline void jump_table_add(jump_table* table, size_t row, unsigned int pi, unsigned int pn, int phase, int n_quanta) {
+  // Counts an entry of row while counting, stores it while filling, a NULL table is one the run does not build
+  if (table == NULL) {return;}
+  if (table->compressed) {jump_table_add_compressed(table, row, pi, pn, phase, n_quanta); return;}
+  if (table->fill == NULL) {table->start[row + 1]++; return;}
+  size_t k = table->fill[row]++;
+  table->pi[k] = pi;
+  if (table->with_pn) {
+    table->pn[k] = pn;
+    table->phase[k] = (signed char) phase;
+  }
+  if (table->with_quanta) {table->n_quanta[k] = n_quanta;}
+}
+
+static inline void jump_cursor_init(jump_cursor* cursor, const jump_table* table, size_t row) {
+  // Positions cursor before the first entry of row
+  cursor->table = table;
+  cursor->k = table->start[row];
+  cursor->end = table->start[row + 1];
+  cursor->p = NULL;
+  cursor->pi = 0;
+  cursor->pn = 0;
+  cursor->phase = 1;
+  cursor->n_quanta = 0;
+  if (table->compressed) {cursor->p = table->stream + table->byte_start[row];}
+}
+
+static inline int jump_cursor_next(jump_cursor* cursor) {
+  // Moves to the next entry of the row, returns 0 once the row is exhausted
+  if (cursor->k == cursor->end) {return 0;}
+  const jump_table *table = cursor->table;
+  if (cursor->p == NULL) {
+    size_t k = cursor->k++;
+    cursor->pi = table->pi[k];
+    if (table->with_pn) {
+      cursor->pn = table->pn[k];
+      cursor->phase = table->phase[k];
+    }
+    if (table->with_quanta) {cursor->n_quanta = table->n_quanta[k];}
+    return 1;
+  }
+  cursor->k++;
+  uint64_t v;
+  cursor->p = jump_varint_get(cursor->p, &v);
+  cursor->pi += (unsigned int) jump_unzigzag(v);
+  if (table->with_pn) {
+    cursor->p = jump_varint_get(cursor->p, &v);
+    cursor->phase = (v & 1) ? -1 : 1;
+    cursor->pn = (unsigned int) ((int64_t) cursor->pi + jump_unzigzag(v >> 1));
+  }
+  if (table->with_quanta) {
+    cursor->p = jump_varint_get(cursor->p, &v);
+    cursor->n_quanta = (int) jump_unzigzag(v);
+  }
+  return 1;
+}
+
+#endif
@@ -1,12 +1,14 @@
-#include "density.h"
+#include "bench.h"
 
 int main(int argc, char *argv[]) {
   clock_t start, end;
   double cpu_time;
   start = clock();
-  if (argc != 2) {printf("Please supply only the parameter file name to the command line\n"); exit(0);}
+  if ((argc != 2) && ((argc != 3) || (strcmp(argv[2], "bench") != 0))) {printf("Please supply only the parameter file name to the command line (optionally followed by bench)\n"); exit(0);}
   speedParams* sp = read_parameter_file(argv[1]);
-  if ((sp->n_body == 1) && (sp->spec_dep == 0)) {
+  if (argc == 3) {
+    run_benchmarks(sp);
+  } else if ((sp->n_body == 1) && (sp->spec_dep == 0)) {
     one_body_density_trunc(sp);
   } else if ((sp->n_body == 1) && (sp->spec_dep == 1)) {
     one_body_density_spec(sp);
@@ -18,5 +20,6 @@ int main(int argc, char *argv[]) {
   end = clock();
   cpu_time = ((double) (end - start))/CLOCKS_PER_SEC;
   printf("Time: %g sec\n", cpu_time);
+  speed_params_free(sp);
   return 0;
 }
@@ -0,0 +1,253 @@
+#include "resolve.h"
+
+resolved_cache* resolved_cache_create(double max_mb, int spill) {
+/* Allocate an empty cache of resolved jump tables
+
+  Input(s):
+    double max_mb: memory cap for tables held in memory, in MB
+    int spill: 1 to write tables beyond the cap to a scratch file, 0 to drop them
+
+  Output(s):
+    resolved_cache* cache: the cache
+*/
+  resolved_cache *cache = malloc(sizeof(*cache));
+  if (cache == NULL) {printf("Error allocating resolved jump cache\n"); exit(0);}
+  cache->table = (resolved_table**) calloc(RESOLVED_HASH_SIZE, sizeof(resolved_table*));
+  if (cache->table == NULL) {printf("Error allocating resolved jump cache\n"); exit(0);}
+  cache->bytes_used = 0.0;
+  cache->bytes_max = max_mb*1024*1024;
+  cache->spill = spill;
+  cache->spill_file = NULL;
+  cache->scratch = NULL;
+  cache->n_hits = 0;
+  cache->n_built = 0;
+  cache->n_spilled = 0;
+  cache->n_dropped = 0;
+  cache->n_direct = 0;
+
+  return cache;
+}
+
+void resolved_table_free(resolved_table* table) {
+  if (table == NULL) {return;}
+  free(table->index_i);
+  free(table->index_f);
+  free(table->phase);
+  free(table->bin);
+  free(table);
+  return;
+}
+
+void resolved_cache_free(resolved_cache* cache) {
+  if (cache == NULL) {return;}
+  for (int h = 0; h < RESOLVED_HASH_SIZE; h++) {
+    resolved_table *table = cache->table[h];
+    while (table != NULL) {
+      resolved_table *next = table->next;
+      resolved_table_free(table);
+      table = next;
+    }
+  }
+  free(cache->table);
+  resolved_table_free(cache->scratch);
+  if (cache->spill_file != NULL) {fclose(cache->spill_file);}
+  free(cache);
+  return;
+}
+
+void resolved_cache_report(resolved_cache* cache) {
+  // Prints how often resolved tables were reused and where they were kept
+  if (cache == NULL) {return;}
+  printf("Resolved jumps: %lld tables built, %lld reused, %lld spilled, %lld dropped (%lld direct traces), %g MB in memory\n", cache->n_built, cache->n_hits, cache->n_spilled, cache->n_dropped, cache->n_direct, cache->bytes_used/(1024*1024));
+  return;
+}
+
+static int resolved_hash(const int* key) {
+  unsigned int hash = 0;
+  for (int k = 0; k < 6; k++) {hash = 31*hash + (unsigned int) (key[k] + 1);}
+  return hash % RESOLVED_HASH_SIZE;
+}
+
+static size_t resolved_pair_bytes(const resolved_table* table) {
+  return 2*sizeof(basis_int) + sizeof(signed char) + (table->with_bins ? sizeof(unsigned short) : 0);
+}
+
+static resolved_table* resolved_lookup(resolved_cache* cache, const int* key) {
+  // The table or dropped record of the operator, NULL if it has not been built
+  resolved_table *table = cache->table[resolved_hash(key)];
+  while (table != NULL) {
+    if (memcmp(table->key, key, 6*sizeof(int)) == 0) {break;}
+    table = table->next;
+  }
+  return table;
+}
+
+resolved_table* resolved_begin(resolved_cache* cache, int kernel, int a, int b, int c, int d, int i_op, int with_bins) {
+/* Allocate an empty table for the operator (kernel, a, b, c, d, i_op)
+   Unused shell arguments are passed as -1. The table grows within the cap of cache
+   (none if cache is NULL). Returns NULL if the operator was dropped before, its
+   kernel then traces it directly
+*/
+  int key[6] = {kernel, a, b, c, d, i_op};
+  if (cache != NULL) {
+    resolved_table *record = resolved_lookup(cache, key);
+    if ((record != NULL) && record->dropped) {
+      cache->n_direct++;
+      return NULL;
+    }
+  }
+  resolved_table *table = malloc(sizeof(*table));
+  if (table == NULL) {printf("Error allocating resolved jump table\n"); exit(0);}
+  table->key[0] = kernel;
+  table->key[1] = a;
+  table->key[2] = b;
+  table->key[3] = c;
+  table->key[4] = d;
+  table->key[5] = i_op;
+  table->n = 0;
+  table->n_max = 0;
+  table->index_i = NULL;
+  table->index_f = NULL;
+  table->phase = NULL;
+  table->bin = NULL;
+  table->with_bins = with_bins;
+  table->spill_offset = -1;
+  table->full = 0;
+  table->dropped = 0;
+  table->cache = cache;
+  table->next = NULL;
+  resolved_grow(table);
+
+  return table;
+}
+
+int resolved_grow(resolved_table* table) {
+/* Doubles the room of the table, or grows it up to its budget: the room left under the
+   cap, or the whole cap for a table that will be spilled. Returns 0 and marks the table
+   full once it is at its budget
+*/
+  if (table->full) {return 0;}
+  long long int n_max = (table->n_max == 0) ? 256 : 2*table->n_max;
+  resolved_cache *cache = table->cache;
+  if (cache != NULL) {
+    double budget = cache->spill ? cache->bytes_max : cache->bytes_max - cache->bytes_used;
+    long long int n_budget = MAX(budget, 0.0)/resolved_pair_bytes(table);
+    n_max = MIN(n_max, n_budget);
+    if (n_max <= table->n_max) {
+      table->full = 1;
+      return 0;
+    }
+  }
+  table->n_max = n_max;
+  table->index_i = (basis_int*) realloc(table->index_i, sizeof(basis_int)*table->n_max);
+  table->index_f = (basis_int*) realloc(table->index_f, sizeof(basis_int)*table->n_max);
+  table->phase = (signed char*) realloc(table->phase, sizeof(signed char)*table->n_max);
+  if (table->with_bins) {table->bin = (unsigned short*) realloc(table->bin, sizeof(unsigned short)*table->n_max);}
+  if ((table->index_i == NULL) || (table->index_f == NULL) || (table->phase == NULL) || (table->with_bins && (table->bin == NULL))) {printf("Error allocating resolved jump table\n"); exit(0);}
+  return 1;
+}
+
+static void resolved_drop(resolved_cache* cache, resolved_table* table) {
+  // Frees the pairs of the table and keeps it as the record of a dropped operator
+  cache->n_dropped++;
+  free(table->index_i);
+  free(table->index_f);
+  free(table->phase);
+  free(table->bin);
+  table->index_i = NULL;
+  table->index_f = NULL;
+  table->phase = NULL;
+  table->bin = NULL;
+  table->n = 0;
+  table->n_max = 0;
+  table->dropped = 1;
+  return;
+}
+
+void resolved_store(resolved_cache* cache, resolved_table* table) {
+/* Adds a finished table to the cache
+   Tables that do not fit under the memory cap are written to the scratch file,
+   or dropped if they are full or spilling is disabled or fails. The table must not
+   be used afterwards
+*/
+  cache->n_built++;
+  double bytes = (double) table->n*resolved_pair_bytes(table);
+  if (table->full) {
+    resolved_drop(cache, table);
+  } else if (cache->bytes_used + bytes <= cache->bytes_max) {
+    // Trim the arrays to their final size
+    if (table->n > 0) {
+      table->n_max = table->n;
+      table->index_i = (basis_int*) realloc(table->index_i, sizeof(basis_int)*table->n);
+      table->index_f = (basis_int*) realloc(table->index_f, sizeof(basis_int)*table->n);
+      table->phase = (signed char*) realloc(table->phase, sizeof(signed char)*table->n);
+      if (table->with_bins) {table->bin = (unsigned short*) realloc(table->bin, sizeof(unsigned short)*table->n);}
+    }
+    cache->bytes_used += bytes;
+  } else {
+    if (cache->spill && (cache->spill_file == NULL)) {
+      cache->spill_file = tmpfile();
+      if (cache->spill_file == NULL) {
+        printf("Could not open a scratch file, resolved jumps over the memory cap will be dropped\n");
+        cache->spill = 0;
+      }
+    }
+    int spilled = 0;
+    if (cache->spill) {
+      fseek(cache->spill_file, 0, SEEK_END);
+      table->spill_offset = ftell(cache->spill_file);
+      spilled = (fwrite(table->index_i, sizeof(basis_int), table->n, cache->spill_file) == table->n);
+      spilled = spilled && (fwrite(table->index_f, sizeof(basis_int), table->n, cache->spill_file) == table->n);
+      spilled = spilled && (fwrite(table->phase, sizeof(signed char), table->n, cache->spill_file) == table->n);
+      if (table->with_bins) {spilled = spilled && (fwrite(table->bin, sizeof(unsigned short), table->n, cache->spill_file) == table->n);}
+    }
+    if (spilled) {
+      cache->n_spilled++;
+      free(table->index_i);
+      free(table->index_f);
+      free(table->phase);
+      free(table->bin);
+      table->index_i = NULL;
+      table->index_f = NULL;
+      table->phase = NULL;
+      table->bin = NULL;
+      table->n_max = 0;
+    } else {
+      resolved_drop(cache, table);
+    }
+  }
+  int h = resolved_hash(table->key);
+  table->next = cache->table[h];
+  cache->table[h] = table;
+
+  return;
+}
+
+resolved_table* resolved_find(resolved_cache* cache, int kernel, int a, int b, int c, int d, int i_op) {
+/* Returns the resolved table of the operator, or NULL if it has not been built or
+   was dropped. A spilled table is read back into the cache's scratch table, which
+   stays valid until the next call
+*/
+  int key[6] = {kernel, a, b, c, d, i_op};
+  resolved_table *table = resolved_lookup(cache, key);
+  if ((table == NULL) || table->dropped) {return NULL;}
+  cache->n_hits++;
+  if (table->spill_offset < 0) {return table;}
+
+  if ((cache->scratch == NULL) || (cache->scratch->with_bins != table->with_bins)) {
+    resolved_table_free(cache->scratch);
+    cache->scratch = resolved_begin(NULL, kernel, a, b, c, d, i_op, table->with_bins);
+  }
+  resolved_table *scratch = cache->scratch;
+  while (scratch->n_max < table->n) {resolved_grow(scratch);}
+  memcpy(scratch->key, key, sizeof(key));
+  scratch->n = table->n;
+  fseek(cache->spill_file, table->spill_offset, SEEK_SET);
+  int valid = (fread(scratch->index_i, sizeof(basis_int), table->n, cache->spill_file) == table->n);
+  valid = valid && (fread(scratch->index_f, sizeof(basis_int), table->n, cache->spill_file) == table->n);
+  valid = valid && (fread(scratch->phase, sizeof(signed char), table->n, cache->spill_file) == table->n);
+  if (scratch->with_bins) {valid = valid && (fread(scratch->bin, sizeof(unsigned short), table->n, cache->spill_file) == table->n);}
+  if (!valid) {printf("Error reading resolved jumps from the scratch file\n"); exit(0);}
+
+  return scratch;
+}
@@ -0,0 +1,75 @@
+#ifndef RESOLVE_H
+#define RESOLVE_H
+#include "basis.h"
+
+/* Resolved jump tables
+   A trace kernel walks its jump lists and looks up the initial and final basis states
+   of every pair of jumps. The result depends only on the operator (the kernel and its
+   shells) so it can be stored once as flat arrays of (index_i, index_f, phase) and
+   replayed as a gather-multiply-accumulate whenever the operator is traced again.
+   Tables are held in memory up to a cap, beyond which they are spilled to a scratch
+   file or dropped. A table stops collecting pairs once it would outgrow the cap, its
+   kernel traces the remaining pairs directly and the operator is recorded as dropped,
+   so later calls trace it directly without collecting again
+*/
+
+#define RESOLVED_HASH_SIZE 4099
+
+// Trace kernels with resolved tables
+#define RESOLVED_A4 0
+#define RESOLVED_A22 1
+#define RESOLVED_A20 2
+#define RESOLVED_T0 3
+#define RESOLVED_T2 4
+#define RESOLVED_A4_SPEC 5
+#define RESOLVED_A22_SPEC 6
+#define RESOLVED_A20_SPEC 7
+#define RESOLVED_T0_SPEC 8
+#define RESOLVED_T2_SPEC 9
+
+typedef struct resolved_table
+{
+  int key[6]; // kernel, a, b, c, d, i_op
+  long long int n, n_max;
+  basis_int *index_i, *index_f;
+  signed char *phase;
+  int with_bins;
+  unsigned short *bin; // spectator bin of each pair, NULL outside spectator mode
+  long int spill_offset; // position in the scratch file, -1 if the table is in memory
+  int full; // stopped collecting at its memory budget, the pairs held are only part of the operator
+  int dropped; // kept only as the record of a dropped operator, holds no pairs
+  struct resolved_cache *cache; // cache whose cap bounds the growth of the table, NULL for none
+  struct resolved_table *next;
+} resolved_table;
+
+typedef struct resolved_cache
+{
+  resolved_table **table;
+  double bytes_used, bytes_max;
+  int spill;
+  FILE *spill_file;
+  resolved_table *scratch; // holds a spilled table while it is traced
+  long long int n_hits, n_built, n_spilled, n_dropped, n_direct;
+} resolved_cache;
+
+resolved_cache* resolved_cache_create(double max_mb, int spill);
+void resolved_cache_free(resolved_cache* cache);
+void resolved_cache_report(resolved_cache* cache);
+resolved_table* resolved_find(resolved_cache* cache, int kernel, int a, int b, int c, int d, int i_op);
+resolved_table* resolved_begin(resolved_cache* cache, int kernel, int a, int b, int c, int d, int i_op, int with_bins);
+int resolved_grow(resolved_table* table);
+void resolved_store(resolved_cache* cache, resolved_table* table);
+void resolved_table_free(resolved_table* table);
+
+static inline int resolved_push(resolved_table* table, basis_int index_i, basis_int index_f, int phase, int bin) {
+  // Appends a pair, returns 0 if the table is full and the caller must trace the pair itself
+  if ((table->n == table->n_max) && !resolved_grow(table)) {return 0;}
+  table->index_i[table->n] = index_i;
+  table->index_f[table->n] = index_f;
+  table->phase[table->n] = phase;
+  if (table->with_bins) {table->bin[table->n] = bin;}
+  table->n++;
+  return 1;
+}
+
+#endif
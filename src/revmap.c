@@ -0,0 +1,190 @@
+#include "revmap.h"
+
+rev_map* rev_map_create(int n_s, int n_p_int, int n_created, int mode) {
+/* Allocate an empty reverse map
+
+  Input(s):
+    int n_s: number of single-particle states
+    int n_p_int: number of particles in the intermediate SDs
+    int n_created: number of particles created to reach the final SDs, 1 or 2
+    int mode: REV_MAP_DENSE, REV_MAP_RUNS or REV_MAP_DEMAND, where dense maps over
+      REV_MAP_DENSE_MAX_MB, and on-demand maps whose orbitals do not fit in an
+      occupation mask, are stored as runs instead
+
+  Output(s):
+    rev_map* map: the map, to be filled with rev_map_set and closed with rev_map_finish
+*/
+  rev_map *map = malloc(sizeof(*map));
+  if (map == NULL) {printf("Error allocating reverse map\n"); exit(0);}
+  if ((mode == REV_MAP_DEMAND) && (sd_mask_words(n_s) == 0)) {mode = REV_MAP_RUNS;}
+  map->n_s = n_s;
+  map->n_p_int = n_p_int;
+  map->n_created = n_created;
+  map->n_pairs = (n_created == 1) ? n_s : n_s*n_s;
+  map->n_sds_int = get_num_sds(n_s, n_p_int);
+  map->n_sds_f = get_num_sds(n_s, n_p_int + n_created);
+  if ((mode == REV_MAP_DENSE) && (sizeof(int)*(double) map->n_pairs*map->n_sds_int > REV_MAP_DENSE_MAX_MB*1024.0*1024.0)) {mode = REV_MAP_RUNS;}
+  map->mode = mode;
+  map->dense = NULL;
+  map->start = NULL;
+  map->entry = NULL;
+  map->n_run = NULL;
+  map->n_run_max = NULL;
+  map->run = NULL;
+  map->stored_f = NULL;
+  map->stored_int = NULL;
+  if (mode == REV_MAP_DENSE) {
+    map->dense = (int*) calloc(checked_count(map->n_pairs, 1, map->n_sds_int), sizeof(int));
+    if (map->dense == NULL) {printf("Error allocating reverse map\n"); exit(0);}
+  } else if (mode == REV_MAP_RUNS) {
+    map->n_run = (size_t*) calloc(map->n_pairs, sizeof(size_t));
+    map->n_run_max = (size_t*) calloc(map->n_pairs, sizeof(size_t));
+    map->run = (uint64_t**) calloc(map->n_pairs, sizeof(uint64_t*));
+    if ((map->n_run == NULL) || (map->n_run_max == NULL) || (map->run == NULL)) {printf("Error allocating reverse map\n"); exit(0);}
+  } else {
+    map->stored_f = (unsigned char*) calloc((size_t) map->n_sds_f + 1, sizeof(unsigned char));
+    map->stored_int = (unsigned char*) calloc((size_t) map->n_sds_int + 1, sizeof(unsigned char));
+    if ((map->stored_f == NULL) || (map->stored_int == NULL)) {printf("Error allocating reverse map\n"); exit(0);}
+  }
+
+  return map;
+}
+
+static void rev_map_free_runs(rev_map* map) {
+  if (map->run != NULL) {
+    for (int pair = 0; pair < map->n_pairs; pair++) {free(map->run[pair]);}
+  }
+  free(map->run);
+  free(map->n_run);
+  free(map->n_run_max);
+  map->run = NULL;
+  map->n_run = NULL;
+  map->n_run_max = NULL;
+}
+
+void rev_map_free(rev_map* map) {
+  if (map == NULL) {return;}
+  rev_map_free_runs(map);
+  free(map->dense);
+  free(map->start);
+  free(map->entry);
+  free(map->stored_f);
+  free(map->stored_int);
+  free(map);
+  return;
+}
+
+void rev_map_push(rev_map* map, unsigned int pn, int pair, int value) {
+  // Appends an entry to the run of the slot pair while the map is being built
+  if (map->run == NULL) {printf("Error: reverse map is written after it was finished\n"); exit(0);}
+  if (map->n_run[pair] == map->n_run_max[pair]) {
+    map->n_run_max[pair] = (map->n_run_max[pair] == 0) ? 16 : 2*map->n_run_max[pair];
+    map->run[pair] = (uint64_t*) realloc(map->run[pair], sizeof(uint64_t)*map->n_run_max[pair]);
+    if (map->run[pair] == NULL) {printf("Error allocating reverse map\n"); exit(0);}
+  }
+  map->run[pair][map->n_run[pair]++] = ((uint64_t) pn << 32) | (uint32_t) value;
+  return;
+}
+
+static int rev_entry_compare(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*) a;
+  uint64_t y = *(const uint64_t*) b;
+  return (x > y) - (x < y);
+}
+
+void rev_map_finish(rev_map* map) {
+/* Closes a map once its builder is done
+   Runs are sorted by intermediate SD and packed into one array, the other modes
+   need no work. Safe to call on NULL or on a map that is already finished
+*/
+  if ((map == NULL) || (map->mode != REV_MAP_RUNS) || (map->run == NULL)) {return;}
+  map->start = (size_t*) malloc(sizeof(size_t)*(map->n_pairs + 1));
+  if (map->start == NULL) {printf("Error allocating reverse map\n"); exit(0);}
+  map->start[0] = 0;
+  for (int pair = 0; pair < map->n_pairs; pair++) {map->start[pair + 1] = map->start[pair] + map->n_run[pair];}
+  map->entry = (uint64_t*) malloc(sizeof(uint64_t)*MAX(map->start[map->n_pairs], 1));
+  if (map->entry == NULL) {printf("Error allocating reverse map\n"); exit(0);}
+  for (int pair = 0; pair < map->n_pairs; pair++) {
+    if (map->n_run[pair] == 0) {continue;}
+    qsort(map->run[pair], map->n_run[pair], sizeof(uint64_t), rev_entry_compare);
+    memcpy(&map->entry[map->start[pair]], map->run[pair], sizeof(uint64_t)*map->n_run[pair]);
+  }
+  rev_map_free_runs(map);
+
+  return;
+}
+
+double rev_map_memory(rev_map* map) {
+  // Bytes held by a finished map
+  if (map == NULL) {return 0.0;}
+  if (map->mode == REV_MAP_DENSE) {return sizeof(int)*(double) map->n_pairs*map->n_sds_int;}
+  if (map->mode == REV_MAP_DEMAND) {return (double) map->n_sds_f + map->n_sds_int + 2;}
+  if (map->start == NULL) {return 0.0;}
+  return sizeof(size_t)*(double) (map->n_pairs + 1) + sizeof(uint64_t)*(double) map->start[map->n_pairs];
+}
+
+double rev_map_estimate(int n_s, int n_p_int, int n_created) {
+  // Bytes of a dense map from the SDs of n_p_int particles, whatever the mode the map is kept in
+  if (n_p_int < 0) {return 0.0;}
+  double n_pairs = (n_created == 1) ? n_s : (double) n_s*n_s;
+  return sizeof(int)*n_pairs*get_num_sds(n_s, n_p_int);
+}
+
+int rev_map_get_runs(const rev_map* map, unsigned int pn, int pair) {
+  // Binary search of the run of the slot pair
+  size_t lo = map->start[pair];
+  size_t hi = map->start[pair + 1];
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo)/2;
+    unsigned int key = map->entry[mid] >> 32;
+    if (key < pn) {
+      lo = mid + 1;
+    } else if (key > pn) {
+      hi = mid;
+    } else {
+      return (int) (uint32_t) map->entry[mid];
+    }
+  }
+  return 0;
+}
+
+int rev_map_get_demand(const rev_map* map, unsigned int pn, int pair) {
+/* Rebuilds phase*pf by creating the particles of the slot on pn
+   The phase is the one the builders get from annihilating them from pf, and pf
+   is returned only if the builder stored an entry for it and for pn, so the
+   filters of the builder (present SDs, truncation, mj range) are kept
+*/
+  if ((pn > map->n_sds_int) || !map->stored_int[pn]) {return 0;}
+  int n_s = map->n_s;
+  int orbitals[SD_MASK_BITS];
+  orbitals_from_p(pn, n_s, map->n_p_int, orbitals);
+  sd_bits mask;
+  memset(&mask, 0, sizeof(sd_bits));
+  for (int k = 0; k < map->n_p_int; k++) {mask.word[(orbitals[k] - 1) >> 6] |= (uint64_t) 1 << ((orbitals[k] - 1) & 63);}
+  int n_below = 0;
+  int sign = 1;
+  int create[2];
+  if (map->n_created == 1) {
+    create[0] = pair + 1;
+    n_below = sd_mask_below(&mask, create[0]);
+  } else {
+    // The slot b + a*n_s with a < b holds a(a) a(b) |pf>, the slot a + b*n_s its negative
+    int x = pair % n_s;
+    int y = pair/n_s;
+    if (x == y) {return 0;}
+    if (x < y) {sign = -1;}
+    create[0] = MIN(x, y) + 1;
+    create[1] = MAX(x, y) + 1;
+    n_below = sd_mask_below(&mask, create[0]) + sd_mask_below(&mask, create[1]) + 1;
+  }
+  for (int k = 0; k < map->n_created; k++) {
+    uint64_t bit = (uint64_t) 1 << ((create[k] - 1) & 63);
+    if (mask.word[(create[k] - 1) >> 6] & bit) {return 0;}
+    mask.word[(create[k] - 1) >> 6] |= bit;
+  }
+  unsigned int pf = sd_mask_rank(n_s, map->n_p_int + map->n_created, &mask, sd_mask_words(n_s));
+  if ((pf > map->n_sds_f) || !map->stored_f[pf]) {return 0;}
+  if (n_below & 1) {sign = -sign;}
+
+  return sign*(int) pf;
+}
@@ -0,0 +1,71 @@
+#ifndef REVMAP_H
+#define REVMAP_H
+#include "resolve.h"
+
+/* Reverse jump maps
+   The trace kernels go from an intermediate SD pn, reached by annihilating particles
+   from an initial SD, back to the final SDs pf with a(a) |pf> = +-pn (one-body maps)
+   or a(a) a(b) |pf> = +-pn (two-body maps). A map holds phase*pf for each
+   (intermediate SD, orbital or orbital pair), 0 if there is no such final SD.
+   Almost all entries are zero, so besides the dense array the map can be kept as
+   sorted runs of (pn, phase*pf) per orbital pair, or not stored at all and rebuilt
+   on each lookup by acting creation operators on pn
+*/
+
+// Storage modes of the reverse maps
+#define REV_MAP_DENSE 0
+#define REV_MAP_RUNS 1
+#define REV_MAP_DEMAND 2
+
+typedef struct rev_map
+{
+  int mode;
+  int n_s, n_p_int; // orbitals and particles of the intermediate SDs
+  int n_created; // particles created to go back to the final SD, 1 or 2
+  int n_pairs; // n_s or n_s*n_s orbital (pair) slots
+  unsigned int n_sds_int, n_sds_f; // all SDs of n_p_int and n_p_int + n_created particles
+  int *dense; // phase*pf at (pn - 1) + n_sds_int*pair
+  // Sorted runs, run of the slot pair in [start[pair], start[pair + 1]), entries are (pn << 32) | phase*pf
+  size_t *start;
+  uint64_t *entry;
+  size_t *n_run, *n_run_max; // runs while the map is being built, one buffer per slot
+  uint64_t **run;
+  // On demand, the final and intermediate SDs that were stored, only those are returned
+  unsigned char *stored_f, *stored_int;
+} rev_map;
+
+rev_map* rev_map_create(int n_s, int n_p_int, int n_created, int mode);
+void rev_map_free(rev_map* map);
+void rev_map_finish(rev_map* map);
+double rev_map_memory(rev_map* map);
+double rev_map_estimate(int n_s, int n_p_int, int n_created);
+void rev_map_push(rev_map* map, unsigned int pn, int pair, int value);
+int rev_map_get_runs(const rev_map* map, unsigned int pn, int pair);
+int rev_map_get_demand(const rev_map* map, unsigned int pn, int pair);
+
+static inline void rev_map_set(rev_map* map, unsigned int pn, int pair, int value) {
+  // Stores phase*pf for the intermediate SD pn and orbital (pair) slot pair, a NULL map is one the run does not build
+  if (map == NULL) {return;}
+  if (map->mode == REV_MAP_DENSE) {
+    map->dense[(pn - 1) + (size_t) map->n_sds_int*pair] = value;
+  } else if (map->mode == REV_MAP_DEMAND) {
+    map->stored_int[pn] = 1;
+    map->stored_f[abs(value)] = 1;
+  } else {
+    rev_map_push(map, pn, pair, value);
+  }
+}
+
+static inline int rev_map_parallel(const rev_map* map) {
+  // 1 if rev_map_set may be called from several threads, each (pn, pair) slot having a single writer
+  return (map == NULL) || (map->mode == REV_MAP_DENSE);
+}
+
+static inline int rev_map_get(const rev_map* map, unsigned int pn, int pair) {
+  // Returns phase*pf for the intermediate SD pn and orbital (pair) slot pair, 0 if there is none
+  if (map->mode == REV_MAP_DENSE) {return map->dense[(pn - 1) + (size_t) map->n_sds_int*pair];}
+  if (map->mode == REV_MAP_RUNS) {return rev_map_get_runs(map, pn, pair);}
+  return rev_map_get_demand(map, pn, pair);
+}
+
+#endif
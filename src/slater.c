@@ -12,7 +12,7 @@ unsigned int p_step(int n_s, int n_p, int *m_p) {
   Output(s): 
     int p: p-coefficient of the given Slater determinant
 */
-  unsigned int p = gsl_sf_choose(n_s, n_p);
+  unsigned int p = n_choose_k(n_s, n_p);
   for (int i = 0; i < n_p; i++) {
     p -= n_choose_k(n_s-m_p[i], n_p - i);
   }
@@ -35,16 +35,14 @@ void orbitals_from_p(unsigned int p, int n_s, int n_p, int* orbitals) {
 
 */
   unsigned int q = n_choose_k(n_s, n_p) - p;
-  int j_min = 1;
+  int j = 1;
   for (int k = 0; k < n_p; k++) {
-    for (int j = j_min; j <= n_s; j++) {
-      if ((q >= n_choose_k(n_s - j, n_p - k)) && (q < n_choose_k(n_s - (j - 1), n_p - k))) {
-        orbitals[k] = j;
-        q -= n_choose_k(n_s - j, n_p  - k);
-        j_min = j+1;
-        break;
-      }
-    }
+    // q < C(n_s - (j - 1), n_p - k) holds on entry, so only the lower bound is tested
+    unsigned int c;
+    while (q < (c = n_choose_k(n_s - j, n_p - k))) {j++;}
+    orbitals[k] = j;
+    q -= c;
+    j++;
   }
   return;
 }
@@ -84,8 +82,10 @@ unsigned int a_op(int n_s, int n_p, unsigned int p, int n_op, int *phase, int j_
       // then we know that this state is unoccied and we can return zero
       if (j <= n_op) {return 0;} else {break;}
     }
-    // This inequality is satisfied if the j-th orbital is occupied
-    if ((q >= n_choose_k(n_s - j, n_p - ki)) && (q < n_choose_k(n_s - (j - 1), n_p - ki))) {
+    // The j-th orbital is occupied if q >= C(n_s - j, n_p - ki)
+    // The upper bound q < C(n_s - (j - 1), n_p - ki) holds for every j from j_min on
+    unsigned int c = n_choose_k(n_s - j, n_p - ki);
+    if (q >= c) {
       if (j != n_op) { // Found orbital to keep in the final SD
         pf -= n_choose_k(n_s - j, n_p - kf - 1);
         kf++;
@@ -93,7 +93,7 @@ unsigned int a_op(int n_s, int n_p, unsigned int p, int n_op, int *phase, int j_
       if (j < n_op) { // We must anticommute the annihilation operator past this creation operator
         *phase *= -1;
       }
-      q -= n_choose_k(n_s - j, n_p  - ki); 
+      q -= c;
       ki++;
     } else if (j == n_op) { // Target state is empty so operator annihilates the initial SD
       return 0;
@@ -115,6 +115,8 @@ unsigned int get_num_sds(int n_s, int n_p) {
 
   unsigned int n_sds = 1;
   if (n_p <= 0) {return 1;}
+  // SDs are stored as signed p-coefficients, so the count must fit in an int
+  if (gsl_sf_choose(n_s, n_p) > INT_MAX) {printf("Error: %d particles in %d orbitals give more SDs than fit in an int\n", n_p, n_s); exit(0);}
   int* max_state = (int*) malloc(sizeof(int)*n_p);
   for (int i = 0; i < n_p; i++) {
     max_state[i] = n_s - (n_p - i - 1);
@@ -241,6 +243,252 @@ int w_from_p(unsigned int p, int n_s, int n_p, int* w_shell) {
 }
 
 
+void decode_sd(unsigned int p, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, int* w_shell, int* orbitals, sd_info* sd) {
+/* Reconstructs the occupied orbitals of a SD and accumulates its quantum numbers
+   in a single pass, in place of separate calls to j_min_from_p, m_from_p,
+   parity_from_p, w_from_p and get_m_pi_q
+   Shell arrays passed as NULL are skipped and leave their total at zero
+
+  Input(s):
+    unsigned int p: SD p-coefficient
+    int n_s: number of single-particle states
+    int n_p: number of particles
+    int arrays n_shell, l_shell, jz_shell, w_shell: shell quantum numbers of each orbital
+
+  Output(s):
+    int* orbitals: occupied orbitals in increasing order, if not NULL
+    sd_info* sd: first occupied orbital, total m_j, parity, w and oscillator quanta
+*/
+
+  sd->j_min = 0;
+  sd->mj = 0;
+  sd->parity = 1;
+  sd->w = 0;
+  sd->n_quanta = 0;
+  unsigned int q = n_choose_k(n_s, n_p) - p;
+  int j = 1;
+  for (int k = 0; k < n_p; k++) {
+    // q < C(n_s - (j - 1), n_p - k) holds on entry, so the next orbital is the first j with q >= C(n_s - j, n_p - k)
+    unsigned int c;
+    while (q < (c = n_choose_k(n_s - j, n_p - k))) {j++;}
+    q -= c;
+    if (k == 0) {sd->j_min = j;}
+    if (orbitals != NULL) {orbitals[k] = j;}
+    if (jz_shell != NULL) {sd->mj += jz_shell[j - 1]/2.0;}
+    if (l_shell != NULL) {
+      if (l_shell[j - 1] % 2) {sd->parity *= -1;}
+      if (n_shell != NULL) {sd->n_quanta += 2*n_shell[j - 1] + l_shell[j - 1];}
+    }
+    if (w_shell != NULL) {sd->w += w_shell[j - 1];}
+    j++;
+  }
+
+  return;
+}
+
+static void sd_walk_add(sd_walk* walk, int j, int sign) {
+  // Adds (sign = 1) or removes (sign = -1) orbital j from the running totals
+  if (walk->n_words > 0) {walk->mask.word[(j - 1) >> 6] ^= (uint64_t) 1 << ((j - 1) & 63);}
+  if (walk->jz_shell != NULL) {walk->two_mj += sign*walk->jz_shell[j - 1];}
+  if (walk->l_shell != NULL) {
+    walk->n_odd += sign*(walk->l_shell[j - 1] % 2);
+    if (walk->n_shell != NULL) {walk->sd.n_quanta += sign*(2*walk->n_shell[j - 1] + walk->l_shell[j - 1]);}
+  }
+  if (walk->w_shell != NULL) {walk->sd.w += sign*walk->w_shell[j - 1];}
+}
+
+static void sd_walk_update(sd_walk* walk) {
+  walk->sd.j_min = (walk->n_p > 0) ? walk->orbitals[0] : 0;
+  walk->sd.mj = walk->two_mj/2.0;
+  walk->sd.parity = (walk->n_odd % 2) ? -1 : 1;
+}
+
+void sd_walk_start(sd_walk* walk, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, int* w_shell) {
+/* Positions the walk on the first SD, p = 1, with orbitals 1..n_p occupied
+
+  Input(s):
+    int n_s: number of single-particle states
+    int n_p: number of particles
+    int arrays n_shell, l_shell, jz_shell, w_shell: shell quantum numbers of each orbital, or NULL
+
+  Output(s):
+    sd_walk* walk: the walk, whose sd field holds the same values decode_sd would give
+*/
+  walk->n_s = n_s;
+  walk->n_p = n_p;
+  walk->n_shell = n_shell;
+  walk->l_shell = l_shell;
+  walk->jz_shell = jz_shell;
+  walk->w_shell = w_shell;
+  walk->orbitals = (int*) malloc(sizeof(int)*(n_p + 1));
+  if (walk->orbitals == NULL) {printf("Error allocating SD walk\n"); exit(0);}
+  walk->p = (n_p <= n_s) ? 1 : 0;
+  walk->n_words = sd_mask_words(n_s);
+  memset(&walk->mask, 0, sizeof(sd_bits));
+  walk->two_mj = 0;
+  walk->n_odd = 0;
+  walk->w_max = INT_MAX;
+  walk->min_w = NULL;
+  walk->sd.w = 0;
+  walk->sd.n_quanta = 0;
+  for (int k = 0; k < n_p; k++) {
+    walk->orbitals[k] = k + 1;
+    if (walk->p != 0) {sd_walk_add(walk, k + 1, 1);}
+  }
+  sd_walk_update(walk);
+
+  return;
+}
+
+static void sd_walk_remove(sd_walk* walk, int k) {
+  // Takes the particle in position k (the last one still placed) out of the SD
+  int j = walk->orbitals[k];
+  sd_walk_add(walk, j, -1);
+  walk->p += n_choose_k(walk->n_s - j, walk->n_p - k);
+}
+
+static int sd_walk_fill(sd_walk* walk, int k, int j_first) {
+/* Places the particles in positions k..n_p - 1 on the lowest orbitals, from j_first on,
+   that keep the total w within w_max. The bound is tested with the least w the
+   remaining particles can add, so only position k can fail, in which case nothing
+   is placed and 0 is returned
+*/
+  int n_s = walk->n_s;
+  int n_p = walk->n_p;
+  int stride = n_s + 2;
+  int j = j_first;
+  for (int i = k; i < n_p; i++) {
+    int n_rest = n_p - 1 - i;
+    while (j <= n_s - n_rest) {
+      int w_j = (walk->w_shell != NULL) ? walk->w_shell[j - 1] : 0;
+      if (walk->sd.w + w_j + walk->min_w[(j + 1) + stride*n_rest] <= walk->w_max) {break;}
+      j++;
+    }
+    if (j > n_s - n_rest) {return 0;}
+    walk->orbitals[i] = j;
+    sd_walk_add(walk, j, 1);
+    walk->p -= n_choose_k(n_s - j, n_p - i);
+    j++;
+  }
+
+  return 1;
+}
+
+void sd_walk_start_trunc(sd_walk* walk, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, int* w_shell, int w_max) {
+/* Positions the walk on the first SD with total w <= w_max, after which sd_walk_next
+   steps only between such SDs, still in increasing p-coefficient order
+   The SDs that share their lowest orbitals are skipped together as soon as the w of
+   those orbitals plus the least w the remaining particles can add exceeds w_max, so
+   the cost of the walk follows the size of the truncated space
+
+  Input(s):
+    int n_s: number of single-particle states
+    int n_p: number of particles
+    int arrays n_shell, l_shell, jz_shell, w_shell: shell quantum numbers of each orbital, or NULL
+    int w_max: largest total w of the SDs visited
+
+  Output(s):
+    sd_walk* walk: the walk, with p = 0 if no SD is within w_max
+*/
+  sd_walk_start(walk, n_s, n_p, n_shell, l_shell, jz_shell, w_shell);
+  walk->w_max = w_max;
+  int stride = n_s + 2;
+  walk->min_w = (int*) malloc(sizeof(int)*stride*(n_p + 1));
+  if (walk->min_w == NULL) {printf("Error allocating SD walk\n"); exit(0);}
+  // Least w of r orbitals from s..n_s, either s is skipped or it is the lowest orbital taken
+  for (int s = 1; s <= n_s + 1; s++) {walk->min_w[s] = 0;}
+  for (int r = 1; r <= n_p; r++) {
+    walk->min_w[(n_s + 1) + stride*r] = INT_MAX/2;
+    for (int s = n_s; s >= 1; s--) {
+      int w_s = (w_shell != NULL) ? w_shell[s - 1] : 0;
+      walk->min_w[s + stride*r] = MIN(walk->min_w[(s + 1) + stride*r], w_s + walk->min_w[(s + 1) + stride*(r - 1)]);
+    }
+  }
+  if ((walk->p == 0) || (walk->sd.w <= w_max)) {return;}
+
+  for (int k = n_p - 1; k >= 0; k--) {sd_walk_remove(walk, k);}
+  if (!sd_walk_fill(walk, 0, 1)) {
+    walk->p = 0;
+    return;
+  }
+  sd_walk_update(walk);
+
+  return;
+}
+
+static int sd_walk_next_trunc(sd_walk* walk) {
+  // Moves the rightmost particle that can go up without leaving the truncation
+  for (int i = walk->n_p - 1; i >= 0; i--) {
+    int j = walk->orbitals[i];
+    sd_walk_remove(walk, i);
+    if (sd_walk_fill(walk, i, j + 1)) {
+      sd_walk_update(walk);
+      return 1;
+    }
+  }
+  walk->p = 0;
+
+  return 0;
+}
+
+int sd_walk_next(sd_walk* walk) {
+/* Steps to the SD with the next p-coefficient, or the next one within w_max if the
+   walk was started with sd_walk_start_trunc
+   Returns 0, and sets walk->p to 0, if the current SD was the last one
+*/
+  if (walk->p == 0) {return 0;}
+  if (walk->min_w != NULL) {return sd_walk_next_trunc(walk);}
+  int n_s = walk->n_s;
+  int n_p = walk->n_p;
+  int *orbitals = walk->orbitals;
+  // Rightmost particle that can still move up
+  int i = n_p - 1;
+  while ((i >= 0) && (orbitals[i] == n_s - (n_p - 1 - i))) {i--;}
+  if (i < 0) {
+    walk->p = 0;
+    return 0;
+  }
+  for (int k = i; k < n_p; k++) {sd_walk_add(walk, orbitals[k], -1);}
+  orbitals[i]++;
+  sd_walk_add(walk, orbitals[i], 1);
+  for (int k = i + 1; k < n_p; k++) {
+    orbitals[k] = orbitals[k - 1] + 1;
+    sd_walk_add(walk, orbitals[k], 1);
+  }
+  walk->p++;
+  sd_walk_update(walk);
+
+  return 1;
+}
+
+void sd_walk_seek(sd_walk* walk, unsigned int p) {
+/* Moves a started walk to the SD with p-coefficient p, or, if the walk is truncated,
+   to the first SD from p on within w_max, so that a range of SDs can be walked on
+   its own. A p past the last SD ends the walk
+*/
+  if (walk->p == 0) {return;}
+  for (int k = 0; k < walk->n_p; k++) {sd_walk_add(walk, walk->orbitals[k], -1);}
+  if ((p == 0) || (p > n_choose_k(walk->n_s, walk->n_p))) {
+    walk->p = 0;
+    return;
+  }
+  orbitals_from_p(p, walk->n_s, walk->n_p, walk->orbitals);
+  for (int k = 0; k < walk->n_p; k++) {sd_walk_add(walk, walk->orbitals[k], 1);}
+  walk->p = p;
+  sd_walk_update(walk);
+  if ((walk->min_w != NULL) && (walk->sd.w > walk->w_max)) {sd_walk_next_trunc(walk);}
+
+  return;
+}
+
+void sd_walk_free(sd_walk* walk) {
+  free(walk->orbitals);
+  free(walk->min_w);
+  walk->orbitals = NULL;
+  walk->min_w = NULL;
+  return;
+}
+
 float m_from_p(unsigned int p, int n_s, int n_p, int* m_shell) {
   /* Returns the total magnetic angular momentum m_j of a given SD p-coefficient
   Uses the same algorithm as orbitals_from_p to reconstruct the occupied orbitals
@@ -428,9 +676,55 @@ int j_min_from_p(int n_s, int n_p, unsigned int p) {
   return 0;
 }
 
-unsigned int n_choose_k(int n, int k) {
-/* Wrapper to gsl code to compute binomial coefficient
+/* Binomial table used by n_choose_k, starts as the single entry C(0, 0) = 1 */
+static unsigned int binomial_base[1] = {1};
+unsigned int *binomial_table = binomial_base;
+int binomial_n_max = 0;
+
+void binomial_table_init(int n_max) {
+/* Builds the table of exact binomial coefficients C(n, k) for 0 <= n, k <= n_max
+   by Pascal's rule, with zeros for k > n. The table only grows, so it can be
+   called once per model space. Entries above UINT_MAX saturate, they cannot
+   occur in the p-coefficients of a space whose SD counts fit in an int
+*/
+  if (n_max <= binomial_n_max) {return;}
+  int stride = n_max + 1;
+  unsigned int *table = (unsigned int*) calloc(checked_count(stride, stride, 1), sizeof(unsigned int));
+  if (table == NULL) {printf("Error allocating binomial table\n"); exit(0);}
+  for (int n = 0; n <= n_max; n++) {
+    table[n*stride] = 1;
+    for (int k = 1; k <= n; k++) {
+      uint64_t c = (uint64_t) table[(n - 1)*stride + k - 1] + table[(n - 1)*stride + k];
+      table[n*stride + k] = (c > UINT_MAX) ? UINT_MAX : c;
+    }
+  }
+  if (binomial_table != binomial_base) {free(binomial_table);}
+  binomial_table = table;
+  binomial_n_max = n_max;
+
+  return;
+}
+
+unsigned int n_choose_k_slow(int n, int k) {
+/* Exact binomial coefficient for arguments outside the table
    Provides zero result when n < k (required for Whitehead algorithms)
+*/
+  if (n < 0 || k < 0) {printf("Error %d %d\n", n, k); return 0;}
+  if (k > n) {return 0;}
+  k = MIN(k, n - k);
+  uint64_t c = 1;
+  for (int i = 1; i <= k; i++) {
+    // c*(n - k + i) is divisible by i, as c = C(n - k + i - 1, i - 1)
+    if (c > UINT64_MAX/(n - k + i)) {return UINT_MAX;}
+    c = c*(n - k + i)/i;
+  }
+
+  return (c > UINT_MAX) ? UINT_MAX : c;
+}
+
+unsigned int n_choose_k_gsl(int n, int k) {
+/* Wrapper to gsl code to compute binomial coefficient, the original n_choose_k,
+   kept as the reference for the binomial benchmark
 */
   if (n < 0 || k < 0) {printf("Error %d %d\n", n, k);}
   unsigned int c = 0;
@@ -440,6 +734,18 @@ unsigned int n_choose_k(int n, int k) {
   return c;
 }
 
+size_t checked_count(size_t a, size_t b, size_t c) {
+/* Element count a*b*c of an allocation, stops if the product overflows size_t
+*/
+  size_t n;
+  if (__builtin_mul_overflow(a, b, &n) || __builtin_mul_overflow(n, c, &n)) {
+    printf("Error: allocation of %zu x %zu x %zu elements overflows\n", a, b, c);
+    exit(0);
+  }
+
+  return n;
+}
+
 /* **** Deprecated code ****
 
 void orbitals_from_binary(int n_s, int n_p, unsigned int b, int* orbitals) {
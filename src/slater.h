@@ -1,8 +1,49 @@
 #ifndef SLATER_H
 #define SLATER_H
 #include "angular.h"
+
+// Quantum numbers of a Slater determinant, filled in by decode_sd
+typedef struct sd_info
+{
+  int j_min; // first occupied orbital, 0 if there are no particles
+  float mj;
+  int parity;
+  int w;
+  int n_quanta;
+} sd_info;
+
+// Occupation mask of a SD, bit j - 1 is set if orbital j is occupied (see sd_mask_rank)
+#define SD_MASK_WORDS 4
+#define SD_MASK_BITS (64*SD_MASK_WORDS)
+
+typedef struct sd_bits
+{
+  uint64_t word[SD_MASK_WORDS];
+} sd_bits;
+
+/* Walk over all SDs of n_p particles in n_s orbitals in increasing p-coefficient order
+   The p-coefficient order is the lexicographic order of the occupied orbitals, so each
+   step is a next-combination move that changes only the trailing orbitals, and the
+   quantum numbers are updated by removing and adding those orbitals
+*/
+typedef struct sd_walk
+{
+  int n_s, n_p;
+  int *n_shell, *l_shell, *jz_shell, *w_shell; // NULL arrays leave their total at zero
+  int *orbitals; // occupied orbitals in increasing order, 1-based
+  unsigned int p; // p-coefficient of the current SD, 0 once the walk is past the last SD
+  sd_bits mask; // occupation mask of the current SD
+  int n_words; // words used by the mask, 0 if n_s > SD_MASK_BITS and the mask is not kept
+  int two_mj, n_odd; // 2 m_j and number of odd-l orbitals, from which sd.mj and sd.parity follow
+  sd_info sd;
+  int w_max;
+  int *min_w; // least w of r orbitals chosen from s..n_s at min_w[s + (n_s + 2)*r], NULL if the walk is not truncated
+} sd_walk;
+
 unsigned int p_step(int n_s, int n_p, int *m_p);
-unsigned int n_choose_k(int n, int k);
+void binomial_table_init(int n_max);
+unsigned int n_choose_k_slow(int n, int k);
+unsigned int n_choose_k_gsl(int n, int k);
 void orbitals_from_p(unsigned int p, int n_s, int n_p, int* orbitals);
 void generate_single_particle_states();
 unsigned int bin_from_p(int n_s, int n_p, unsigned int p);
@@ -29,9 +70,126 @@ int j_min_from_p(int n_s, int n_p, unsigned int p);
 float max_mj(int n_s, int n_p, int *m_shell);
 float min_mj(int n_s, int n_p, int *m_shell);
 unsigned int get_num_sds(int n_s, int n_p);
+size_t checked_count(size_t a, size_t b, size_t c);
 void get_m_pi_q(unsigned int p, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, float* m_j, int* parity, int* n_quanta, int j_min);
 int get_max_n_spec_q(int n_s, int n_p, int* n_shell, int* l_shell);
 int get_min_n_spec_q(int n_s, int n_p, int* n_shell, int* l_shell);
 int w_from_p(unsigned int p, int n_s, int n_p, int* w_shell);
+void sd_walk_start(sd_walk* walk, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, int* w_shell);
+void sd_walk_start_trunc(sd_walk* walk, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, int* w_shell, int w_max);
+int sd_walk_next(sd_walk* walk);
+void sd_walk_seek(sd_walk* walk, unsigned int p);
+void sd_walk_free(sd_walk* walk);
+void decode_sd(unsigned int p, int n_s, int n_p, int* n_shell, int* l_shell, int* jz_shell, int* w_shell, int* orbitals, sd_info* sd);
+
+/* Binomial coefficients C(n, k) for 0 <= n, k <= binomial_n_max, row n at
+   n*(binomial_n_max + 1), built by binomial_table_init
+*/
+extern unsigned int *binomial_table;
+extern int binomial_n_max;
+
+static inline unsigned int n_choose_k(int n, int k) {
+  // The unsigned compares also send negative arguments to the slow path
+  if (((unsigned int) n <= (unsigned int) binomial_n_max) && ((unsigned int) k <= (unsigned int) binomial_n_max)) {
+    return binomial_table[n*(binomial_n_max + 1) + k];
+  }
+  return n_choose_k_slow(n, k);
+}
+
+/* Occupation mask kernels
+   An annihilation operator clears one bit, its phase is the parity of the number of occupied orbitals below
+   it, and the p-coefficient is only ranked for the SDs that survive
+   Masks are 1, 2 or 4 words of 64 orbitals. The width is fixed from n_s when a walk
+   starts, and each width has its own kernel with a constant word count
+*/
+static inline int sd_mask_words(int n_s) {
+  // Number of words in the masks of a space of n_s orbitals, 0 if they do not fit
+  if (n_s <= 64) {return 1;}
+  if (n_s <= 128) {return 2;}
+  if (n_s <= SD_MASK_BITS) {return SD_MASK_WORDS;}
+  return 0;
+}
+
+static inline unsigned int sd_mask_rank(int n_s, int n_p, const sd_bits* mask, int n_words) {
+  // p-coefficient of the SD with occupation mask, orbitals are found in increasing order
+  unsigned int p = n_choose_k(n_s, n_p);
+  int k = 0;
+  for (int w = 0; w < n_words; w++) {
+    uint64_t bits = mask->word[w];
+    while (bits != 0) {
+      int j = 64*w + __builtin_ctzll(bits) + 1;
+      p -= n_choose_k(n_s - j, n_p - k);
+      k++;
+      bits &= bits - 1;
+    }
+  }
+  return p;
+}
+
+static inline int sd_mask_below(const sd_bits* mask, int n_op) {
+  // Number of occupied orbitals below orbital n_op
+  int w_op = (n_op - 1) >> 6;
+  uint64_t bit = (uint64_t) 1 << ((n_op - 1) & 63);
+  int n_below = __builtin_popcountll(mask->word[w_op] & (bit - 1));
+  for (int w = 0; w < w_op; w++) {n_below += __builtin_popcountll(mask->word[w]);}
+  return n_below;
+}
+
+static inline unsigned int sd_mask_annihilate_words(int n_s, int n_p, const sd_bits* mask, int n_words, int n_op, int* phase, sd_bits* mask_f) {
+  int w_op = (n_op - 1) >> 6;
+  uint64_t bit = (uint64_t) 1 << ((n_op - 1) & 63);
+  if (!(mask->word[w_op] & bit)) {return 0;}
+  *phase = (sd_mask_below(mask, n_op) & 1) ? -1 : 1;
+  for (int w = 0; w < n_words; w++) {mask_f->word[w] = mask->word[w];}
+  mask_f->word[w_op] ^= bit;
+  return sd_mask_rank(n_s, n_p - 1, mask_f, n_words);
+}
+
+static inline unsigned int sd_mask_annihilate(int n_s, int n_p, const sd_bits* mask, int n_words, int n_op, int* phase, sd_bits* mask_f) {
+  // Acts a(n_op) on the SD with occupation mask, returns the resulting p-coefficient or 0
+  switch (n_words) {
+    case 1: return sd_mask_annihilate_words(n_s, n_p, mask, 1, n_op, phase, mask_f);
+    case 2: return sd_mask_annihilate_words(n_s, n_p, mask, 2, n_op, phase, mask_f);
+    default: return sd_mask_annihilate_words(n_s, n_p, mask, SD_MASK_WORDS, n_op, phase, mask_f);
+  }
+}
+
+static inline unsigned int sd_mask_hop_words(int n_s, int n_p, const sd_bits* mask, int n_words, int n_a, int n_b, int* phase) {
+  int w_a = (n_a - 1) >> 6;
+  int w_b = (n_b - 1) >> 6;
+  uint64_t bit_a = (uint64_t) 1 << ((n_a - 1) & 63);
+  uint64_t bit_b = (uint64_t) 1 << ((n_b - 1) & 63);
+  if (!(mask->word[w_b] & bit_b)) {return 0;}
+  sd_bits mask_f;
+  for (int w = 0; w < n_words; w++) {mask_f.word[w] = mask->word[w];}
+  mask_f.word[w_b] ^= bit_b;
+  if (mask_f.word[w_a] & bit_a) {return 0;}
+  *phase = ((sd_mask_below(mask, n_b) + sd_mask_below(&mask_f, n_a)) & 1) ? -1 : 1;
+  mask_f.word[w_a] ^= bit_a;
+  return sd_mask_rank(n_s, n_p, &mask_f, n_words);
+}
+
+static inline unsigned int sd_mask_hop(int n_s, int n_p, const sd_bits* mask, int n_words, int n_a, int n_b, int* phase) {
+/* Acts a+(n_a) a(n_b) on the SD with occupation mask, returns the resulting p-coefficient or 0
+   The phase is that of a(n_b) on the SD times that of a(n_a) on the result, the
+   product the two-step one-body kernels form from their a(n_b) and a(n_a) jumps
+*/
+  switch (n_words) {
+    case 1: return sd_mask_hop_words(n_s, n_p, mask, 1, n_a, n_b, phase);
+    case 2: return sd_mask_hop_words(n_s, n_p, mask, 2, n_a, n_b, phase);
+    default: return sd_mask_hop_words(n_s, n_p, mask, SD_MASK_WORDS, n_a, n_b, phase);
+  }
+}
+
+static inline unsigned int sd_annihilate(int n_s, int n_p, unsigned int p, const sd_bits* mask, int n_words, int n_op, int* phase, int j_min, sd_bits* mask_f) {
+/* Acts a(n_op) on the SD p with occupation mask, as a_op does
+   Returns the resulting p-coefficient, or 0 if the orbital is empty, and sets
+   mask_f to the resulting mask. Uses the mask when SD_MASK_OPS is set and the
+   orbitals fit in a mask (n_words > 0), the Whitehead walk of a_op otherwise,
+   in which case mask_f is not used
+*/
+  if (SD_MASK_OPS && (n_words > 0)) {return sd_mask_annihilate(n_s, n_p, mask, n_words, n_op, phase, mask_f);}
+  return a_op(n_s, n_p, p, n_op, phase, j_min);
+}
 
 #endif